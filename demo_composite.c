@@ -0,0 +1,428 @@
+#include "pibench.h"
+#include "simd.h"
+
+#define LAYER_COUNT 4
+#define MODE_COUNT 6
+#define KERNEL_COUNT 4
+#define ROWS_PER_JOB 16
+
+// Even modes read premultiplied layers, odd modes straight-alpha layers
+// that are premultiplied on the fly
+typedef enum {
+    MODE_OVER_PREMUL,
+    MODE_OVER_STRAIGHT,
+    MODE_ADD_PREMUL,
+    MODE_ADD_STRAIGHT,
+    MODE_MUL_PREMUL,
+    MODE_MUL_STRAIGHT
+} blend_mode_t;
+
+static const char *mode_names[MODE_COUNT] = {"OVER-P", "OVER-S", "ADD-P", "ADD-S", "MUL-P", "MUL-S"};
+
+typedef enum {
+    KERNEL_SCALAR,
+    KERNEL_SWAR,
+    KERNEL_SIMD,
+    KERNEL_SIMD_MT
+} blend_kernel_t;
+
+typedef struct {
+    const uint32_t *pixels;
+    int scroll_x, scroll_y;
+} layer_view_t;
+
+typedef struct {
+    const layer_view_t *views;
+    int count;
+    blend_mode_t mode;
+    blend_kernel_t kernel;
+} blend_job_t;
+
+static uint32_t *background = NULL;
+static uint32_t *straight[LAYER_COUNT];
+static uint32_t *premul[LAYER_COUNT];
+static bool layers_ready = false;
+
+static double pixels_done[KERNEL_COUNT][MODE_COUNT];
+static uint64_t usecs[KERNEL_COUNT][MODE_COUNT];
+static float last_time = 0;
+
+// Exact x / 255 rounded, for x up to 255 * 255
+static inline uint32_t div255(uint32_t x)
+{
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+static uint32_t argb(int a, int r, int g, int b)
+{
+    return ((uint32_t)MIN(MAX(a, 0), 255) << 24) | (MIN(MAX(r, 0), 255) << 16) |
+           (MIN(MAX(g, 0), 255) << 8) | MIN(MAX(b, 0), 255);
+}
+
+static uint32_t premultiply(uint32_t s)
+{
+    uint32_t a = s >> 24;
+    return (a << 24) | (div255(((s >> 16) & 0xFF) * a) << 16) |
+           (div255(((s >> 8) & 0xFF) * a) << 8) | div255((s & 0xFF) * a);
+}
+
+// Straight-alpha ARGB layers in the style of UI overlays: a tinted
+// gradient, soft glows, diagonal stripes and a grid of bordered panels
+static uint32_t layer_pixel(int layer, int x, int y)
+{
+    float u = (float)x / VIDEO_WIDTH, v = (float)y / VIDEO_HEIGHT;
+    switch (layer)
+    {
+        case 0:
+            return argb((int)(200 * v), 40, 60 + (int)(120 * u), 160);
+        case 1:
+        {
+            float best = 0;
+            for (int i = 0; i < 5; i++)
+            {
+                float dx = u - (0.1f + 0.2f * i), dy = v - (0.5f + 0.3f * sinf(i * 2.1f));
+                best = MAX(best, 1.0f - sqrtf(dx * dx + dy * dy) * 4.0f);
+            }
+            return argb((int)(255 * best), 255, 160 + 20 * (x & 3), 40);
+        }
+        case 2:
+            return ((x + y) / 24) & 1 ? argb(96, 255, 255, 255) : argb(24, 255, 0, 77);
+        default:
+        {
+            int cx = x % 160, cy = y % 120;
+            bool border = cx < 12 || cx >= 148 || cy < 12 || cy >= 108;
+            bool inner = cx >= 16 && cx < 144 && cy >= 16 && cy < 104;
+            if (inner)
+                return argb(144, 29, 43, 83);
+            return border ? 0 : argb(255, 255, 241, 232);
+        }
+    }
+}
+
+static bool build_layers(void)
+{
+    if (layers_ready)
+        return true;
+
+    if (!background)
+        background = (uint32_t *)malloc(VIDEO_PIXELS * sizeof(uint32_t));
+    if (!background)
+        return false;
+    for (int l = 0; l < LAYER_COUNT; l++)
+    {
+        if (!straight[l])
+            straight[l] = (uint32_t *)malloc(VIDEO_PIXELS * sizeof(uint32_t));
+        if (!premul[l])
+            premul[l] = (uint32_t *)malloc(VIDEO_PIXELS * sizeof(uint32_t));
+        if (!straight[l] || !premul[l])
+            return false;
+    }
+
+    for (int y = 0; y < VIDEO_HEIGHT; y++)
+    {
+        for (int x = 0; x < VIDEO_WIDTH; x++)
+        {
+            int i = y * VIDEO_WIDTH + x;
+            background[i] = ((x >> 5) + (y >> 5)) & 1 ? 0xFF5F574F : 0xFFC2C3C7;
+            for (int l = 0; l < LAYER_COUNT; l++)
+            {
+                straight[l][i] = layer_pixel(l, x, y);
+                premul[l][i] = premultiply(straight[l][i]);
+            }
+        }
+    }
+    layers_ready = true;
+    return true;
+}
+
+// Scalar: one channel at a time on a premultiplied source p with alpha a.
+// Over is p + d(1 - a), add is d + p saturated and multiply is
+// pd + d(1 - a), the separable multiply onto an opaque destination.
+static void blend_span_scalar(uint32_t *dst, const uint32_t *src, int len, blend_mode_t mode)
+{
+    for (int i = 0; i < len; i++)
+    {
+        uint32_t p = (mode & 1) ? premultiply(src[i]) : src[i];
+        uint32_t a = p >> 24, d = dst[i], r = 0;
+        for (int s = 0; s < 32; s += 8)
+        {
+            uint32_t dc = (d >> s) & 0xFF, pc = (p >> s) & 0xFF, c;
+            if (mode <= MODE_OVER_STRAIGHT)
+                c = pc + div255(dc * (255 - a));
+            else if (mode <= MODE_ADD_STRAIGHT)
+                c = MIN(dc + pc, 255);
+            else
+                c = div255(pc * dc) + div255(dc * (255 - a));
+            r |= c << s;
+        }
+        dst[i] = r;
+    }
+}
+
+// SWAR: two 8-bit channels in 16-bit lanes of a 32-bit word, so red/blue
+// and alpha/green each share one multiply by a per-pixel factor
+#define LANES 0x00FF00FFu
+
+static inline uint32_t swar_div255(uint32_t t)
+{
+    t += 0x00800080;
+    return ((t + ((t >> 8) & LANES)) >> 8) & LANES;
+}
+
+static inline uint32_t swar_saturate(uint32_t x)
+{
+    uint32_t carry = (x >> 8) & 0x00010001;
+    return (x | ((carry << 8) - carry)) & LANES;
+}
+
+static inline uint32_t swar_premultiply(uint32_t s)
+{
+    uint32_t a = s >> 24;
+    uint32_t rb = swar_div255((s & LANES) * a);
+    uint32_t g = swar_div255(((s >> 8) & LANES) * a) & 0xFF;
+    return (a << 24) | (g << 8) | rb;
+}
+
+static void blend_span_swar(uint32_t *dst, const uint32_t *src, int len, blend_mode_t mode)
+{
+    for (int i = 0; i < len; i++)
+    {
+        uint32_t p = (mode & 1) ? swar_premultiply(src[i]) : src[i];
+        uint32_t ia = 255 - (p >> 24), d = dst[i];
+        uint32_t d_rb = d & LANES, d_ag = (d >> 8) & LANES;
+        uint32_t p_rb = p & LANES, p_ag = (p >> 8) & LANES;
+        uint32_t rb, ag;
+
+        if (mode <= MODE_OVER_STRAIGHT)
+        {
+            rb = p_rb + swar_div255(d_rb * ia);
+            ag = p_ag + swar_div255(d_ag * ia);
+        }
+        else if (mode <= MODE_ADD_STRAIGHT)
+        {
+            rb = swar_saturate(d_rb + p_rb);
+            ag = swar_saturate(d_ag + p_ag);
+        }
+        else
+        {
+            // Channel-by-channel products cannot share a multiply, so pack
+            // them by hand and keep the rounding and accumulation in SWAR
+            uint32_t pd_rb = (d_rb & 0xFF) * (p_rb & 0xFF) | ((d_rb >> 16) * (p_rb >> 16)) << 16;
+            uint32_t pd_ag = (d_ag & 0xFF) * (p_ag & 0xFF) | ((d_ag >> 16) * (p_ag >> 16)) << 16;
+            rb = swar_div255(pd_rb) + swar_div255(d_rb * ia);
+            ag = swar_div255(pd_ag) + swar_div255(d_ag * ia);
+        }
+        dst[i] = rb | (ag << 8);
+    }
+}
+
+// SIMD: the SWAR layout on four pixels at once, with 16-bit lane
+// multiplies so multiply mode also gets per-channel products
+SIMD_KERNEL v4i v4i_div255(v4i t, v4i lanes)
+{
+    t = v4i_add(t, v4i_set1(0x00800080));
+    return v4i_and(v4i_shr(v4i_add(t, v4i_and(v4i_shr(t, 8), lanes)), 8), lanes);
+}
+
+SIMD_KERNEL v4i v4i_saturate(v4i x, v4i lanes)
+{
+    v4i carry = v4i_and(v4i_shr(x, 8), v4i_set1(0x00010001));
+    return v4i_and(v4i_or(x, v4i_sub(v4i_shl(carry, 8), carry)), lanes);
+}
+
+SIMD_KERNEL void blend_span_simd_body(uint32_t *dst, const uint32_t *src, int len, blend_mode_t mode)
+{
+    const v4i lanes = v4i_set1(LANES);
+    int i = 0;
+
+    for (; i + 4 <= len; i += 4)
+    {
+        v4i p = v4i_load((const int32_t *)src + i);
+        v4i d = v4i_load((const int32_t *)dst + i);
+        v4i a = v4i_shr(p, 24);
+        v4i a2 = v4i_or(a, v4i_shl(a, 16));
+
+        if (mode & 1)
+        {
+            v4i rb = v4i_div255(v4i_mul16(v4i_and(p, lanes), a2), lanes);
+            v4i g = v4i_and(v4i_div255(v4i_mul16(v4i_and(v4i_shr(p, 8), lanes), a2), lanes), v4i_set1(0xFF));
+            p = v4i_or(v4i_shl(a, 24), v4i_or(v4i_shl(g, 8), rb));
+        }
+
+        v4i ia2 = v4i_sub(lanes, a2);
+        v4i d_rb = v4i_and(d, lanes), d_ag = v4i_and(v4i_shr(d, 8), lanes);
+        v4i p_rb = v4i_and(p, lanes), p_ag = v4i_and(v4i_shr(p, 8), lanes);
+        v4i rb, ag;
+
+        if (mode <= MODE_OVER_STRAIGHT)
+        {
+            rb = v4i_add(p_rb, v4i_div255(v4i_mul16(d_rb, ia2), lanes));
+            ag = v4i_add(p_ag, v4i_div255(v4i_mul16(d_ag, ia2), lanes));
+        }
+        else if (mode <= MODE_ADD_STRAIGHT)
+        {
+            rb = v4i_saturate(v4i_add(d_rb, p_rb), lanes);
+            ag = v4i_saturate(v4i_add(d_ag, p_ag), lanes);
+        }
+        else
+        {
+            rb = v4i_add(v4i_div255(v4i_mul16(d_rb, p_rb), lanes), v4i_div255(v4i_mul16(d_rb, ia2), lanes));
+            ag = v4i_add(v4i_div255(v4i_mul16(d_ag, p_ag), lanes), v4i_div255(v4i_mul16(d_ag, ia2), lanes));
+        }
+        v4i_store((int32_t *)dst + i, v4i_or(rb, v4i_shl(ag, 8)));
+    }
+    blend_span_swar(dst + i, src + i, len - i, mode);
+}
+
+SIMD_CLONES(blend_span_simd, (uint32_t *dst, const uint32_t *src, int len, blend_mode_t mode),
+            (dst, src, len, mode))
+
+static void blend_span_simd(uint32_t *dst, const uint32_t *src, int len, blend_mode_t mode)
+{
+    SIMD_CALL(blend_span_simd, (dst, src, len, mode));
+}
+
+static void blend_span(uint32_t *dst, const uint32_t *src, int len, const blend_job_t *job)
+{
+    switch (job->kernel)
+    {
+        case KERNEL_SCALAR:
+            blend_span_scalar(dst, src, len, job->mode);
+            break;
+        case KERNEL_SWAR:
+            blend_span_swar(dst, src, len, job->mode);
+            break;
+        default:
+            blend_span_simd(dst, src, len, job->mode);
+            break;
+    }
+}
+
+// Layers wrap around the screen, so each row is blended as two spans
+static void blend_rows(const blend_job_t *job, int y0, int y1)
+{
+    uint32_t *pixels = (uint32_t *)frame_buf;
+    for (int l = 0; l < job->count; l++)
+    {
+        const layer_view_t *view = &job->views[l];
+        int sx = view->scroll_x;
+        for (int y = y0; y < y1; y++)
+        {
+            uint32_t *dst = pixels + y * VIDEO_WIDTH;
+            const uint32_t *src = view->pixels + ((y + view->scroll_y) % VIDEO_HEIGHT) * VIDEO_WIDTH;
+            blend_span(dst, src + sx, VIDEO_WIDTH - sx, job);
+            blend_span(dst + VIDEO_WIDTH - sx, src, sx, job);
+        }
+    }
+}
+
+static void blend_job(int index, void *arg)
+{
+    int y0 = index * ROWS_PER_JOB;
+    blend_rows((const blend_job_t *)arg, y0, MIN(y0 + ROWS_PER_JOB, VIDEO_HEIGHT));
+}
+
+static void draw_table(const char names[][40])
+{
+    char buf[80], rate[16];
+    int x = 32, y = 144;
+
+    int len = snprintf(buf, sizeof(buf), "%-20s", "PIXELS/S");
+    for (int m = 0; m < MODE_COUNT; m++)
+        len += snprintf(buf + len, sizeof(buf) - len, " %7s", mode_names[m]);
+    draw_text_bg(x, y, buf, 0xFFFFFFFF);
+
+    for (int k = 0; k < KERNEL_COUNT; k++)
+    {
+        len = snprintf(buf, sizeof(buf), "%-20s", names[k]);
+        for (int m = 0; m < MODE_COUNT; m++)
+        {
+            if (usecs[k][m])
+                format_si(rate, sizeof(rate), pixels_done[k][m] * 1000000.0 / usecs[k][m]);
+            else
+                snprintf(rate, sizeof(rate), "-");
+            len += snprintf(buf + len, sizeof(buf) - len, " %7s", rate);
+        }
+        draw_text_bg(x, y + 8 + k * 8, buf, 0xFFFFFFFF);
+    }
+    draw_text_bg(x, y + 16 + KERNEL_COUNT * 8, "-P PREMULTIPLIED, -S STRAIGHT ALPHA", 0xFFFFFFFF);
+}
+
+// Full-screen translucent ARGB layers composited over an opaque backdrop,
+// as frontends do for UI overlays. Stress stacks more copies of the four
+// layers. The demo time is split between scalar, SWAR, SIMD and SIMD
+// across the pool, and within each kernel between the six blend modes.
+void render_composite(float time)
+{
+    static layer_view_t *views = NULL;
+    static int views_capacity = 0;
+    char names[KERNEL_COUNT][40];
+    char label[sizeof("PIXELS/S ()") + sizeof(names[0])];
+    int threads = thread_count();
+    int variant = demo_variant(time, KERNEL_COUNT * MODE_COUNT);
+    int count = LAYER_COUNT * options.stress;
+
+    if (time < last_time)
+    {
+        memset(pixels_done, 0, sizeof(pixels_done));
+        memset(usecs, 0, sizeof(usecs));
+    }
+    last_time = time;
+
+    snprintf(names[KERNEL_SCALAR], sizeof(names[0]), "SCALAR");
+    snprintf(names[KERNEL_SWAR], sizeof(names[0]), "SWAR");
+    snprintf(names[KERNEL_SIMD], sizeof(names[0]), "%s", simd_level_name());
+    snprintf(names[KERNEL_SIMD_MT], sizeof(names[0]), "%s, %d THREAD%s", simd_level_name(), threads,
+             threads > 1 ? "S" : "");
+
+    if (!build_layers())
+    {
+        draw_text_bg(32, 144, "COMPOSITE: OUT OF MEMORY", 0xFFFFFFFF);
+        return;
+    }
+
+    if (views_capacity < count)
+    {
+        layer_view_t *grown = (layer_view_t *)realloc(views, count * sizeof(layer_view_t));
+        if (!grown)
+        {
+            draw_text_bg(32, 144, "COMPOSITE: OUT OF MEMORY", 0xFFFFFFFF);
+            return;
+        }
+        views = grown;
+        views_capacity = count;
+    }
+
+    blend_job_t job;
+    job.kernel = (blend_kernel_t)(variant / MODE_COUNT);
+    job.mode = (blend_mode_t)(variant % MODE_COUNT);
+    job.views = views;
+    job.count = count;
+
+    for (int i = 0; i < count; i++)
+    {
+        int l = i % LAYER_COUNT;
+        float speed = 20.0f + 15.0f * l + 3.0f * (i / LAYER_COUNT);
+        views[i].pixels = (job.mode & 1) ? straight[l] : premul[l];
+        views[i].scroll_x = (int)(time * speed + i * 61) % VIDEO_WIDTH;
+        views[i].scroll_y = (int)(time * speed * 0.5f + i * 37) % VIDEO_HEIGHT;
+    }
+
+    memcpy(frame_buf, background, VIDEO_PIXELS * sizeof(uint32_t));
+
+    uint64_t t0 = get_time_usec();
+    if (job.kernel == KERNEL_SIMD_MT)
+        run_parallel(threads, (VIDEO_HEIGHT + ROWS_PER_JOB - 1) / ROWS_PER_JOB, blend_job, &job);
+    else
+        blend_rows(&job, 0, VIDEO_HEIGHT);
+    uint64_t t1 = get_time_usec();
+
+    pixels_done[job.kernel][job.mode] += (double)count * VIDEO_PIXELS;
+    usecs[job.kernel][job.mode] += t1 - t0;
+
+    snprintf(label, sizeof(label), "PIXELS/S (%s)", names[job.kernel]);
+    add_demo_stat(job.kernel, label, (double)count * VIDEO_PIXELS, t1 - t0);
+
+    draw_table(names);
+}
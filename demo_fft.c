@@ -0,0 +1,407 @@
+#include "pibench.h"
+#include "simd.h"
+
+#define MAX_LOG2 16
+#define MAX_N (1 << MAX_LOG2)
+#define SIZE_COUNT 5
+#define VARIANT_COUNT 5
+#define SPECTRUM_TOP 232
+#define SPECTRUM_BOTTOM 463
+#define SPECTRUM_FLOOR_DB -90.0f
+
+static const int size_log2[SIZE_COUNT] = {8, 10, 12, 14, 16};
+
+// Twiddles for a stage of size m live at [m/2, m): w(j) = exp(-2*pi*i*j/m).
+// The radix-4 passes also need w(3j), stored in the same layout.
+static float *tw_re, *tw_im, *tw3_re, *tw3_im;
+static uint32_t *bit_rev;
+
+// Split-complex signal for the current frame and per-thread work buffers
+static float *src_re, *src_im;
+static float *work_re, *work_im;
+static int work_slices = 0;
+
+static double transforms[VARIANT_COUNT][SIZE_COUNT];
+static uint64_t usecs[VARIANT_COUNT][SIZE_COUNT];
+static float last_time = 0;
+static int frame_counter = 0;
+
+typedef struct {
+    int log2n;
+    bool radix4;
+    bool simd;
+} fft_job_t;
+
+static bool init_tables(void)
+{
+    if (tw_re)
+        return true;
+
+    tw_re = (float *)malloc(MAX_N * sizeof(float));
+    tw_im = (float *)malloc(MAX_N * sizeof(float));
+    tw3_re = (float *)malloc(MAX_N * sizeof(float));
+    tw3_im = (float *)malloc(MAX_N * sizeof(float));
+    bit_rev = (uint32_t *)malloc(MAX_N * sizeof(uint32_t));
+    src_re = (float *)malloc(MAX_N * sizeof(float));
+    src_im = (float *)malloc(MAX_N * sizeof(float));
+    if (!tw_re || !tw_im || !tw3_re || !tw3_im || !bit_rev || !src_re || !src_im)
+    {
+        // Retry next frame from scratch rather than with a partial set
+        free(tw_re);
+        free(tw_im);
+        free(tw3_re);
+        free(tw3_im);
+        free(bit_rev);
+        free(src_re);
+        free(src_im);
+        tw_re = tw_im = tw3_re = tw3_im = src_re = src_im = NULL;
+        bit_rev = NULL;
+        return false;
+    }
+
+    for (int m = 2; m <= MAX_N; m *= 2)
+    {
+        for (int j = 0; j < m / 2; j++)
+        {
+            double a = -2.0 * M_PI * j / m;
+            tw_re[m / 2 + j] = (float)cos(a);
+            tw_im[m / 2 + j] = (float)sin(a);
+            tw3_re[m / 2 + j] = (float)cos(3.0 * a);
+            tw3_im[m / 2 + j] = (float)sin(3.0 * a);
+        }
+    }
+
+    for (uint32_t i = 0; i < MAX_N; i++)
+    {
+        uint32_t r = 0;
+        for (int b = 0; b < MAX_LOG2; b++)
+            r |= ((i >> b) & 1) << (MAX_LOG2 - 1 - b);
+        bit_rev[i] = r;
+    }
+    return true;
+}
+
+static bool init_work(int slices)
+{
+    if (work_slices >= slices)
+        return true;
+
+    free(work_re);
+    free(work_im);
+    work_re = (float *)malloc((size_t)slices * MAX_N * sizeof(float));
+    work_im = (float *)malloc((size_t)slices * MAX_N * sizeof(float));
+    work_slices = (work_re && work_im) ? slices : 0;
+    return work_slices > 0;
+}
+
+static void radix2_stage(float *re, float *im, int n, int half)
+{
+    for (int s = 0; s < n; s += 2 * half)
+    {
+        for (int j = 0; j < half; j++)
+        {
+            int a = s + j, b = a + half;
+            float wr = tw_re[half + j], wi = tw_im[half + j];
+            float tr = re[b] * wr - im[b] * wi;
+            float ti = re[b] * wi + im[b] * wr;
+            re[b] = re[a] - tr;
+            im[b] = im[a] - ti;
+            re[a] += tr;
+            im[a] += ti;
+        }
+    }
+}
+
+// Radix-4 DIT butterfly over bit-reversed input: the four quarters of a
+// block hold the sub-DFTs of x[4k], x[4k+2], x[4k+1] and x[4k+3]
+static void radix4_stage(float *re, float *im, int n, int q)
+{
+    const int m = 4 * q;
+    for (int s = 0; s < n; s += m)
+    {
+        for (int j = 0; j < q; j++)
+        {
+            int i0 = s + j, i1 = i0 + q, i2 = i1 + q, i3 = i2 + q;
+            float w1r = tw_re[2 * q + j], w1i = tw_im[2 * q + j];
+            float w2r = tw_re[q + j], w2i = tw_im[q + j];
+            float w3r = tw3_re[2 * q + j], w3i = tw3_im[2 * q + j];
+
+            float y1r = re[i2] * w1r - im[i2] * w1i, y1i = re[i2] * w1i + im[i2] * w1r;
+            float y2r = re[i1] * w2r - im[i1] * w2i, y2i = re[i1] * w2i + im[i1] * w2r;
+            float y3r = re[i3] * w3r - im[i3] * w3i, y3i = re[i3] * w3i + im[i3] * w3r;
+
+            float t0r = re[i0] + y2r, t0i = im[i0] + y2i;
+            float t1r = re[i0] - y2r, t1i = im[i0] - y2i;
+            float t2r = y1r + y3r, t2i = y1i + y3i;
+            float t3r = y1r - y3r, t3i = y1i - y3i;
+
+            re[i0] = t0r + t2r;
+            im[i0] = t0i + t2i;
+            re[i2] = t0r - t2r;
+            im[i2] = t0i - t2i;
+            re[i1] = t1r + t3i;
+            im[i1] = t1i - t3r;
+            re[i3] = t1r - t3i;
+            im[i3] = t1i + t3r;
+        }
+    }
+}
+
+// (ar + i*ai) * (br + i*bi), four lanes at a time
+static inline void cmul4(v4f ar, v4f ai, v4f br, v4f bi, v4f *rr, v4f *ri)
+{
+    *rr = v4f_sub(v4f_mul(ar, br), v4f_mul(ai, bi));
+    *ri = v4f_madd(ar, bi, v4f_mul(ai, br));
+}
+
+static void radix2_stage_simd(float *re, float *im, int n, int half)
+{
+    if (half < 4)
+    {
+        radix2_stage(re, im, n, half);
+        return;
+    }
+
+    for (int s = 0; s < n; s += 2 * half)
+    {
+        for (int j = 0; j < half; j += 4)
+        {
+            int a = s + j, b = a + half;
+            v4f tr, ti;
+            cmul4(v4f_load(re + b), v4f_load(im + b),
+                  v4f_load(tw_re + half + j), v4f_load(tw_im + half + j), &tr, &ti);
+            v4f ar = v4f_load(re + a), ai = v4f_load(im + a);
+            v4f_store(re + b, v4f_sub(ar, tr));
+            v4f_store(im + b, v4f_sub(ai, ti));
+            v4f_store(re + a, v4f_add(ar, tr));
+            v4f_store(im + a, v4f_add(ai, ti));
+        }
+    }
+}
+
+static void radix4_stage_simd(float *re, float *im, int n, int q)
+{
+    if (q < 4)
+    {
+        radix4_stage(re, im, n, q);
+        return;
+    }
+
+    const int m = 4 * q;
+    for (int s = 0; s < n; s += m)
+    {
+        for (int j = 0; j < q; j += 4)
+        {
+            int i0 = s + j, i1 = i0 + q, i2 = i1 + q, i3 = i2 + q;
+            v4f y1r, y1i, y2r, y2i, y3r, y3i;
+            cmul4(v4f_load(re + i2), v4f_load(im + i2),
+                  v4f_load(tw_re + 2 * q + j), v4f_load(tw_im + 2 * q + j), &y1r, &y1i);
+            cmul4(v4f_load(re + i1), v4f_load(im + i1),
+                  v4f_load(tw_re + q + j), v4f_load(tw_im + q + j), &y2r, &y2i);
+            cmul4(v4f_load(re + i3), v4f_load(im + i3),
+                  v4f_load(tw3_re + 2 * q + j), v4f_load(tw3_im + 2 * q + j), &y3r, &y3i);
+
+            v4f x0r = v4f_load(re + i0), x0i = v4f_load(im + i0);
+            v4f t0r = v4f_add(x0r, y2r), t0i = v4f_add(x0i, y2i);
+            v4f t1r = v4f_sub(x0r, y2r), t1i = v4f_sub(x0i, y2i);
+            v4f t2r = v4f_add(y1r, y3r), t2i = v4f_add(y1i, y3i);
+            v4f t3r = v4f_sub(y1r, y3r), t3i = v4f_sub(y1i, y3i);
+
+            v4f_store(re + i0, v4f_add(t0r, t2r));
+            v4f_store(im + i0, v4f_add(t0i, t2i));
+            v4f_store(re + i2, v4f_sub(t0r, t2r));
+            v4f_store(im + i2, v4f_sub(t0i, t2i));
+            v4f_store(re + i1, v4f_add(t1r, t3i));
+            v4f_store(im + i1, v4f_sub(t1i, t3r));
+            v4f_store(re + i3, v4f_sub(t1r, t3i));
+            v4f_store(im + i3, v4f_add(t1i, t3r));
+        }
+    }
+}
+
+// Out-of-place forward FFT of the source signal into re/im
+static void fft(float *re, float *im, int log2n, bool radix4, bool simd)
+{
+    const int n = 1 << log2n;
+    const int shift = MAX_LOG2 - log2n;
+
+    for (int i = 0; i < n; i++)
+    {
+        re[i] = src_re[bit_rev[i] >> shift];
+        im[i] = src_im[bit_rev[i] >> shift];
+    }
+
+    // m is the size of the sub-DFTs finished so far
+    int m = 1;
+    if (radix4)
+    {
+        // An odd number of radix-2 levels leaves one radix-2 pass first
+        if (log2n & 1)
+        {
+            radix2_stage(re, im, n, 1);
+            m = 2;
+        }
+        for (; m < n; m *= 4)
+        {
+            if (simd)
+                radix4_stage_simd(re, im, n, m);
+            else
+                radix4_stage(re, im, n, m);
+        }
+    }
+    else
+    {
+        for (; m < n; m *= 2)
+        {
+            if (simd)
+                radix2_stage_simd(re, im, n, m);
+            else
+                radix2_stage(re, im, n, m);
+        }
+    }
+}
+
+static void fft_job(int index, void *arg)
+{
+    const fft_job_t *job = (const fft_job_t *)arg;
+    size_t offset = (size_t)index << job->log2n;
+    fft(work_re + offset, work_im + offset, job->log2n, job->radix4, job->simd);
+}
+
+// Hann-windowed test signal: a sweeping tone with two harmonics, a fixed
+// tone and a little white noise
+static void make_signal(int n, float time)
+{
+    double f0 = 0.02 + 0.15 * (0.5 + 0.5 * sin(time * 0.7));
+    uint32_t seed = 0x1234567u + frame_counter;
+
+    for (int t = 0; t < n; t++)
+    {
+        double w = 0.5 - 0.5 * cos(2.0 * M_PI * t / n);
+        double x = sin(2.0 * M_PI * f0 * t) + 0.3 * sin(2.0 * M_PI * 2.0 * f0 * t) +
+                   0.1 * sin(2.0 * M_PI * 3.0 * f0 * t) + 0.5 * sin(2.0 * M_PI * 0.31 * t);
+        seed = seed * 1664525u + 1013904223u;
+        x += 0.05 * ((seed >> 8) * (1.0 / 16777216.0) - 0.5);
+        src_re[t] = (float)(x * w);
+        src_im[t] = 0.0f;
+    }
+}
+
+// Magnitude spectrum in dB, one vertical bar per column showing the
+// loudest bin it covers
+static void draw_spectrum(const float *re, const float *im, int n)
+{
+    uint32_t *pixels = (uint32_t *)frame_buf;
+    const int x0 = 32, width = VIDEO_WIDTH - 64;
+    const int height = SPECTRUM_BOTTOM - SPECTRUM_TOP;
+    const int bins = n / 2;
+    const float scale = 4.0f / n; // Hann window halves a tone's peak
+
+    for (int x = 0; x < width; x++)
+    {
+        int k0 = x * bins / width;
+        int k1 = MAX((x + 1) * bins / width, k0 + 1);
+        float peak = 0.0f;
+        for (int k = k0; k < k1; k++)
+            peak = fmaxf(peak, re[k] * re[k] + im[k] * im[k]);
+
+        float db = 10.0f * log10f(peak * scale * scale + 1e-12f);
+        float t = fminf(fmaxf(1.0f - db / SPECTRUM_FLOOR_DB, 0.0f), 1.0f);
+        int h = (int)(t * height);
+
+        for (int y = SPECTRUM_BOTTOM - h; y <= SPECTRUM_BOTTOM; y++)
+        {
+            int level = (SPECTRUM_BOTTOM - y) * 255 / height;
+            pixels[y * VIDEO_WIDTH + x0 + x] = 0xFF000000 | (level << 16) | ((255 - level / 2) << 8) | 64;
+        }
+    }
+}
+
+static void draw_table(const char **names)
+{
+    char buf[80], rate[16];
+    int x = 32, y = 160;
+
+    int len = snprintf(buf, sizeof(buf), "%-24s", "FFT TRANSFORMS/S");
+    for (int s = 0; s < SIZE_COUNT; s++)
+        len += snprintf(buf + len, sizeof(buf) - len, " %7d", 1 << size_log2[s]);
+    draw_text_bg(x, y, buf, 0xFFFFFFFF);
+
+    for (int v = 0; v < VARIANT_COUNT; v++)
+    {
+        len = snprintf(buf, sizeof(buf), "%-24s", names[v]);
+        for (int s = 0; s < SIZE_COUNT; s++)
+        {
+            if (usecs[v][s])
+                format_si(rate, sizeof(rate), transforms[v][s] * 1000000.0 / usecs[v][s]);
+            else
+                snprintf(rate, sizeof(rate), "-");
+            len += snprintf(buf + len, sizeof(buf) - len, " %7s", rate);
+        }
+        draw_text_bg(x, y + 8 + v * 8, buf, 0xFFFFFFFF);
+    }
+}
+
+// Complex FFTs of 256 to 64K points. The demo time is split between
+// radix-2 and radix-4 passes with scalar and SIMD butterflies, then batches
+// of independent radix-4 SIMD transforms across the worker pool. Every frame
+// transforms 64K samples in total at one size and plots the last spectrum.
+void render_fft(float time)
+{
+    char names[VARIANT_COUNT][32];
+    const char *name_ptrs[VARIANT_COUNT];
+    char label[40];
+    int threads = thread_count();
+    int variant = demo_variant(time, VARIANT_COUNT);
+
+    if (time < last_time)
+    {
+        memset(transforms, 0, sizeof(transforms));
+        memset(usecs, 0, sizeof(usecs));
+    }
+    last_time = time;
+
+    if (!init_tables() || !init_work(threads))
+    {
+        draw_text_bg(32, 160, "FFT: OUT OF MEMORY", 0xFFFFFFFF);
+        return;
+    }
+
+    for (int v = 0; v < VARIANT_COUNT; v++)
+    {
+        if (v < 4)
+            snprintf(names[v], sizeof(names[v]), "RADIX-%d %s", v & 1 ? 4 : 2, v < 2 ? "SCALAR" : SIMD_NAME);
+        else
+            snprintf(names[v], sizeof(names[v]), "RADIX-4 %s, %d THREAD%s", SIMD_NAME, threads,
+                     threads > 1 ? "S" : "");
+        name_ptrs[v] = names[v];
+    }
+
+    int s = frame_counter++ % SIZE_COUNT;
+    int log2n = size_log2[s];
+    int n = 1 << log2n;
+    fft_job_t job = {log2n, (variant & 1) || variant == 4, variant >= 2};
+    int count = (MAX_N / n) * (variant == 4 ? threads : 1);
+
+    make_signal(n, time);
+
+    uint64_t t0 = get_time_usec();
+    if (variant == 4)
+        run_parallel(threads, count, fft_job, &job);
+    else
+    {
+        for (int i = 0; i < count; i++)
+            fft(work_re, work_im, log2n, job.radix4, job.simd);
+    }
+    uint64_t t1 = get_time_usec();
+
+    transforms[variant][s] += count;
+    usecs[variant][s] += t1 - t0;
+
+    // The usual 5 N log2 N flop count for a complex radix-2 FFT
+    snprintf(label, sizeof(label), "FLOPS (%s)", names[variant]);
+    add_demo_stat(variant, label, 5.0 * n * log2n * count, t1 - t0);
+
+    draw_table(name_ptrs);
+    draw_spectrum(work_re, work_im, n);
+}
@@ -0,0 +1,53 @@
+#include "pibench.h"
+
+// Concentric filled circles drawn as scanline spans: a pure fill-rate test.
+// Each stress level adds three more overlapping circle sets.
+void render_fill(float current_time) {
+    uint64_t pixels = 0;
+    uint64_t t0 = get_time_usec();
+
+    for (int q = 1; q <= 3 * options.stress; q++) {
+        int p = 1 << (1 + (q - 1) % 3);  // p = 2, 4, 8
+        int set = (q - 1) / 3;
+        float phase_x = current_time / 6.0f + p / 3.0f + set * 1.7f;
+        float phase_y = current_time / 5.0f + p / 5.0f + set * 2.3f;
+        
+        // Calculate center position (scaled to 640x480)
+        int center_x = 320 + (int)(cosf(phase_x) * (21.0f + set * 40.0f));
+        int center_y = 240 + (int)(cosf(phase_y) * (25.0f + set * 30.0f));
+
+        for (int r = 128; r >= 4; r -= 4) {
+            // Alternate the set color with a darker shade so every ring shows
+            uint32_t color = 0;
+            switch (p) {
+                case 2:  color = 0x00FF0000; break;  // Red
+                case 4:  color = 0x0000FF00; break;  // Green
+                case 8:  color = 0x000000FF; break;  // Blue
+            }
+            if (!(r & 4))
+                color = (color >> 2) & 0x003F3F3F;
+
+            // Draw filled circle
+            for (int y = -r; y <= r; y++) {
+                int current_y = center_y + y;
+                if (current_y < 0 || current_y >= VIDEO_HEIGHT) continue;
+                
+                int width = (int)sqrtf(r * r - y * y);
+                int start_x = center_x - width;
+                int end_x = center_x + width;
+                
+                // Clamp to screen bounds
+                start_x = start_x < 0 ? 0 : start_x;
+                end_x = end_x >= VIDEO_WIDTH ? VIDEO_WIDTH - 1 : end_x;
+                if (start_x > end_x) continue;
+
+                // Fill scanline with color
+                uint32_t *row = (uint32_t *)frame_buf + current_y * VIDEO_WIDTH;
+                fill_span(row + start_x, end_x - start_x + 1, color);
+                pixels += end_x - start_x + 1;
+            }
+        }
+    }
+
+    add_demo_stat(0, "PIXELS/S FILLED", (double)pixels, get_time_usec() - t0);
+}
@@ -0,0 +1,338 @@
+#include "pibench.h"
+
+#if defined(__aarch64__)
+#include <arm_acle.h>
+#ifdef __linux__
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+#define HW_CRC_NAME "CRC32C ARMV8"
+#elif defined(__x86_64__)
+#include <nmmintrin.h>
+#define HW_CRC_NAME "CRC32C SSE4.2"
+#else
+#define HW_CRC_NAME "CRC32C HW"
+#endif
+
+#define SIZE_COUNT 5
+#define ALGO_COUNT 4
+#define MAX_SIZE (64 << 20)
+#define FRAME_BYTES (8 << 20) // Small buffers are hashed repeatedly up to this much per frame
+#define CRC32C_POLY 0x82F63B78 // Castagnoli, reflected; the polynomial both CPU families implement
+
+static const int sizes[SIZE_COUNT] = {64, 4 << 10, 256 << 10, 4 << 20, MAX_SIZE};
+static const char *size_names[SIZE_COUNT] = {"64B", "4KB", "256KB", "4MB", "64MB"};
+
+typedef enum {
+    ALGO_CRC_TABLE,
+    ALGO_CRC_SLICE8,
+    ALGO_CRC_HW,
+    ALGO_XXH64
+} hash_algo_t;
+
+static uint32_t crc_table[8][256];
+static uint8_t *data = NULL;
+static uint32_t expected_crc[SIZE_COUNT];
+static bool data_ready = false;
+static bool has_hw_crc = false;
+
+static double bytes_done[ALGO_COUNT][SIZE_COUNT];
+static uint64_t usecs[ALGO_COUNT][SIZE_COUNT];
+static double mcycles[ALGO_COUNT][SIZE_COUNT]; // Elapsed usec times clock in MHz
+static float last_time = 0;
+static int frame_counter = 0;
+
+static inline uint64_t read64(const uint8_t *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t read32(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// Table 0 is the classic byte-at-a-time table; table k advances a byte
+// k positions further, so eight lookups consume eight bytes at once
+static void build_crc_tables(void)
+{
+    for (int i = 0; i < 256; i++)
+    {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++)
+            c = (c >> 1) ^ (c & 1 ? CRC32C_POLY : 0);
+        crc_table[0][i] = c;
+    }
+    for (int i = 0; i < 256; i++)
+        for (int t = 1; t < 8; t++)
+            crc_table[t][i] = (crc_table[t - 1][i] >> 8) ^ crc_table[0][crc_table[t - 1][i] & 0xFF];
+}
+
+static uint32_t crc32c_table(const uint8_t *p, size_t n)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    while (n--)
+        crc = (crc >> 8) ^ crc_table[0][(crc ^ *p++) & 0xFF];
+    return ~crc;
+}
+
+// Assumes a little-endian host, like every board we target
+static uint32_t crc32c_slice8(const uint8_t *p, size_t n)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    for (; n >= 8; n -= 8, p += 8)
+    {
+        uint32_t lo = read32(p) ^ crc, hi = read32(p + 4);
+        crc = crc_table[7][lo & 0xFF] ^ crc_table[6][(lo >> 8) & 0xFF] ^
+              crc_table[5][(lo >> 16) & 0xFF] ^ crc_table[4][lo >> 24] ^
+              crc_table[3][hi & 0xFF] ^ crc_table[2][(hi >> 8) & 0xFF] ^
+              crc_table[1][(hi >> 16) & 0xFF] ^ crc_table[0][hi >> 24];
+    }
+    while (n--)
+        crc = (crc >> 8) ^ crc_table[0][(crc ^ *p++) & 0xFF];
+    return ~crc;
+}
+
+// The CRC instructions are optional in ARMv8.0 and need SSE4.2 on x86,
+// so they are compiled for that target and only called when present
+#if defined(__aarch64__)
+__attribute__((target("+crc")))
+static uint32_t crc32c_hw(const uint8_t *p, size_t n)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    for (; n >= 8; n -= 8, p += 8)
+        crc = __crc32cd(crc, read64(p));
+    while (n--)
+        crc = __crc32cb(crc, *p++);
+    return ~crc;
+}
+
+static bool detect_hw_crc(void)
+{
+#ifdef __linux__
+    return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+#else
+    return false;
+#endif
+}
+#elif defined(__x86_64__)
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_hw(const uint8_t *p, size_t n)
+{
+    uint64_t crc = 0xFFFFFFFF;
+    for (; n >= 8; n -= 8, p += 8)
+        crc = _mm_crc32_u64(crc, read64(p));
+    while (n--)
+        crc = _mm_crc32_u8((uint32_t)crc, *p++);
+    return ~(uint32_t)crc;
+}
+
+static bool detect_hw_crc(void)
+{
+    return __builtin_cpu_supports("sse4.2");
+}
+#else
+static uint32_t crc32c_hw(const uint8_t *p, size_t n)
+{
+    return crc32c_slice8(p, n);
+}
+
+static bool detect_hw_crc(void)
+{
+    return false;
+}
+#endif
+
+// XXH64: a fast non-cryptographic hash, four independent 64-bit lanes
+#define XXH_P1 0x9E3779B185EBCA87ull
+#define XXH_P2 0xC2B2AE3D27D4EB4Full
+#define XXH_P3 0x165667B19E3779F9ull
+#define XXH_P4 0x85EBCA77C2B2AE63ull
+#define XXH_P5 0x27D4EB2F165667C5ull
+
+static inline uint64_t rotl64(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t xxh64_round(uint64_t acc, uint64_t input)
+{
+    acc += input * XXH_P2;
+    return rotl64(acc, 31) * XXH_P1;
+}
+
+static inline uint64_t xxh64_merge(uint64_t acc, uint64_t v)
+{
+    acc ^= xxh64_round(0, v);
+    return acc * XXH_P1 + XXH_P4;
+}
+
+static uint64_t xxh64(const uint8_t *p, size_t n, uint64_t seed)
+{
+    const uint8_t *end = p + n;
+    uint64_t h;
+
+    if (n >= 32)
+    {
+        uint64_t v1 = seed + XXH_P1 + XXH_P2, v2 = seed + XXH_P2, v3 = seed, v4 = seed - XXH_P1;
+        for (; end - p >= 32; p += 32)
+        {
+            v1 = xxh64_round(v1, read64(p));
+            v2 = xxh64_round(v2, read64(p + 8));
+            v3 = xxh64_round(v3, read64(p + 16));
+            v4 = xxh64_round(v4, read64(p + 24));
+        }
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = xxh64_merge(h, v1);
+        h = xxh64_merge(h, v2);
+        h = xxh64_merge(h, v3);
+        h = xxh64_merge(h, v4);
+    }
+    else
+        h = seed + XXH_P5;
+
+    h += n;
+    for (; end - p >= 8; p += 8)
+        h = rotl64(h ^ xxh64_round(0, read64(p)), 27) * XXH_P1 + XXH_P4;
+    if (end - p >= 4)
+    {
+        h = rotl64(h ^ (read32(p) * XXH_P1), 23) * XXH_P2 + XXH_P3;
+        p += 4;
+    }
+    for (; p < end; p++)
+        h = rotl64(h ^ (*p * XXH_P5), 11) * XXH_P1;
+
+    h ^= h >> 33;
+    h *= XXH_P2;
+    h ^= h >> 29;
+    h *= XXH_P3;
+    h ^= h >> 32;
+    return h;
+}
+
+static bool build_data(void)
+{
+    if (data_ready)
+        return true;
+    if (!data)
+        data = (uint8_t *)malloc(MAX_SIZE);
+    if (!data)
+        return false;
+
+    uint32_t x = 2463534242u;
+    for (int i = 0; i < MAX_SIZE; i += 4)
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        memcpy(data + i, &x, 4);
+    }
+
+    build_crc_tables();
+    has_hw_crc = detect_hw_crc();
+    for (int s = 0; s < SIZE_COUNT; s++)
+        expected_crc[s] = crc32c_table(data, sizes[s]);
+    data_ready = true;
+    return true;
+}
+
+static void draw_table(const char *names[], int y, bool per_cycle)
+{
+    char buf[80], rate[16];
+    int x = 32;
+
+    int len = snprintf(buf, sizeof(buf), "%-16s", per_cycle ? "BYTES/CYCLE" : "BYTES/S");
+    for (int s = 0; s < SIZE_COUNT; s++)
+        len += snprintf(buf + len, sizeof(buf) - len, " %8s", size_names[s]);
+    draw_text_bg(x, y, buf, 0xFFFFFFFF);
+
+    for (int a = 0; a < ALGO_COUNT; a++)
+    {
+        len = snprintf(buf, sizeof(buf), "%-16s", names[a]);
+        for (int s = 0; s < SIZE_COUNT; s++)
+        {
+            if (a == ALGO_CRC_HW && !has_hw_crc)
+                snprintf(rate, sizeof(rate), "N/A");
+            else if (!usecs[a][s] || (per_cycle && mcycles[a][s] <= 0))
+                snprintf(rate, sizeof(rate), "-");
+            else if (per_cycle)
+                snprintf(rate, sizeof(rate), "%.2f", bytes_done[a][s] / mcycles[a][s]);
+            else
+                format_si(rate, sizeof(rate), bytes_done[a][s] * 1000000.0 / usecs[a][s]);
+            len += snprintf(buf + len, sizeof(buf) - len, " %8s", rate);
+        }
+        draw_text_bg(x, y + 8 + a * 8, buf, 0xFFFFFFFF);
+    }
+}
+
+// Checksums over random data from 64 B to 64 MB: CRC32C with a byte
+// table, with slice-by-8 tables and with the CPU's CRC instructions, and
+// the XXH64 hash. The demo time is split between the four, and each frame
+// measures one size, repeating small buffers so the timer can resolve
+// them. Bytes per cycle use the cpu0 clock sampled after each frame.
+void render_hash(float time)
+{
+    static const char *names[ALGO_COUNT] = {"CRC32C TABLE", "CRC32C SLICE-8", HW_CRC_NAME, "XXH64"};
+    char label[48];
+    hash_algo_t algo = (hash_algo_t)demo_variant(time, ALGO_COUNT);
+
+    if (time < last_time)
+    {
+        memset(bytes_done, 0, sizeof(bytes_done));
+        memset(usecs, 0, sizeof(usecs));
+        memset(mcycles, 0, sizeof(mcycles));
+    }
+    last_time = time;
+
+    if (!build_data())
+    {
+        draw_text_bg(32, 144, "HASH: OUT OF MEMORY", 0xFFFFFFFF);
+        return;
+    }
+
+    int s = frame_counter++ % SIZE_COUNT;
+    int reps = MAX(FRAME_BYTES / sizes[s], 1);
+    bool ok = true;
+
+    if (algo != ALGO_CRC_HW || has_hw_crc)
+    {
+        uint64_t sink = 0;
+        uint64_t t0 = get_time_usec();
+        for (int r = 0; r < reps; r++)
+        {
+            switch (algo)
+            {
+                case ALGO_CRC_TABLE: sink += crc32c_table(data, sizes[s]); break;
+                case ALGO_CRC_SLICE8: sink += crc32c_slice8(data, sizes[s]); break;
+                case ALGO_CRC_HW: sink += crc32c_hw(data, sizes[s]); break;
+                default: sink += xxh64(data, sizes[s], r); break;
+            }
+        }
+        uint64_t t1 = get_time_usec();
+        float mhz = get_cpu_frequency();
+
+        // Every CRC rep returns the same value, so the sum checks them all
+        if (algo != ALGO_XXH64)
+            ok = sink == (uint64_t)expected_crc[s] * reps;
+
+        double bytes = (double)sizes[s] * reps;
+        bytes_done[algo][s] += bytes;
+        usecs[algo][s] += t1 - t0;
+        if (mhz > 0)
+            mcycles[algo][s] += (t1 - t0) * (double)mhz;
+
+        snprintf(label, sizeof(label), "BYTES/S (%s)", names[algo]);
+        add_demo_stat(algo, label, bytes, t1 - t0);
+    }
+
+    draw_table(names, 144, false);
+    draw_table(names, 200, true);
+    if (algo == ALGO_CRC_HW && !has_hw_crc)
+        draw_text_bg(32, 256, "NO CRC32 INSTRUCTIONS ON THIS CPU", 0xFFFFFFFF);
+    if (!ok)
+        draw_text_bg(32, 264, "HASH: CRC MISMATCH", 0xFFFF004D);
+}
@@ -20,18 +20,191 @@ static const uint32_t pico_palette[16] = {
     0xFFCCAA  // 15: Peach
 };
 
+#define LINE_THICKNESS 4 // Added thickness control
+#define LINE_INTENSITY 4 // Exact lines hit each pixel once, so add a visible step
+
+static const uint8_t color_remap[16] = {0, 0, 0, 0, 8, 8, 14, 14, 7, 7, 7, 7, 7, 7, 7, 7};
+
+static uint8_t pixel_buffer[VIDEO_HEIGHT][VIDEO_WIDTH];
+
+// Nibble-packed variant (~150 KB): even pixels in the low nibble, odd in the high
+static uint8_t packed_buffer[VIDEO_HEIGHT][VIDEO_WIDTH / 2];
+
+#define NIBBLE_HIGH_BITS 0x8888888888888888ULL
+#define NIBBLE_ONES 0x1111111111111111ULL
+
+// Add per nibble modulo 16 without carries crossing nibbles (every nibble of add < 8)
+static inline uint64_t nibble_add(uint64_t x, uint64_t add)
+{
+    return ((x & ~NIBBLE_HIGH_BITS) + add) ^ (x & NIBBLE_HIGH_BITS);
+}
+
+static void increment_span_packed(int y, int x0, int x1, uint8_t step)
+{
+    uint8_t *row = packed_buffer[y];
+
+    // Unaligned head and tail pixels share a byte with their neighbour
+    if (x0 & 1)
+    {
+        row[x0 >> 1] = (uint8_t)nibble_add(row[x0 >> 1], step << 4);
+        x0++;
+    }
+    if (!(x1 & 1) && x1 >= x0)
+    {
+        row[x1 >> 1] = (uint8_t)nibble_add(row[x1 >> 1], step);
+        x1--;
+    }
+
+    int b = x0 >> 1;
+    int end = (x1 >> 1) + 1;
+    uint64_t add = step * NIBBLE_ONES;
+
+    for (; b < end && (b & 7); b++)
+        row[b] = (uint8_t)nibble_add(row[b], add);
+    for (; b + 8 <= end; b += 8)
+    {
+        uint64_t w;
+        memcpy(&w, row + b, sizeof(w));
+        w = nibble_add(w, add);
+        memcpy(row + b, &w, sizeof(w));
+    }
+    for (; b < end; b++)
+        row[b] = (uint8_t)nibble_add(row[b], add);
+}
+
+static void resolve_packed(void)
+{
+    static uint32_t pair_lut[256][2];
+    static bool lut_ready = false;
+
+    // One lookup per byte yields both pixels
+    if (!lut_ready)
+    {
+        for (int b = 0; b < 256; b++)
+        {
+            pair_lut[b][0] = pico_palette[color_remap[b & 15]];
+            pair_lut[b][1] = pico_palette[color_remap[b >> 4]];
+        }
+        lut_ready = true;
+    }
+
+    const uint8_t *src = &packed_buffer[0][0];
+    uint32_t *dst = (uint32_t *)frame_buf;
+    for (int i = 0; i < VIDEO_PIXELS / 2; i++)
+    {
+        dst[0] = pair_lut[src[i]][0];
+        dst[1] = pair_lut[src[i]][1];
+        dst += 2;
+    }
+}
+
+static void increment_span(int y, int x0, int x1, uint8_t step)
+{
+    if (options.laser_packed)
+    {
+        increment_span_packed(y, x0, x1, step);
+        return;
+    }
+
+    uint8_t *row = pixel_buffer[y];
+    for (int x = x0; x <= x1; x++)
+        row[x] = (row[x] + step) & 15;
+}
+
+// Original renderer: step 128 fixed samples and stamp a square at each
+// one, pixel by pixel
+static void draw_line_sampled(float x0, float y0, float x1, float y1)
+{
+    float dx = (x1 - x0) / 128.0f;
+    float dy = (y1 - y0) / 128.0f;
+
+    float x = x0, y = y0;
+    for (int j = 0; j < 128; j++)
+    {
+        int ix = (int)x;
+        int iy = (int)y;
+
+        // Draw thick points
+        for (int tx = -LINE_THICKNESS / 2; tx <= LINE_THICKNESS / 2; tx++)
+        {
+            for (int ty = -LINE_THICKNESS / 2; ty <= LINE_THICKNESS / 2; ty++)
+            {
+                int nx = ix + tx;
+                int ny = iy + ty;
+                if (nx >= 0 && nx < VIDEO_WIDTH && ny >= 0 && ny < VIDEO_HEIGHT)
+                {
+                    if (options.laser_packed)
+                        increment_span_packed(ny, nx, nx, 1);
+                    else
+                        pixel_buffer[ny][nx] = (pixel_buffer[ny][nx] + 1) % 16;
+                }
+            }
+        }
+
+        x += dx;
+        y += dy;
+    }
+}
+
+// Exact renderer: the segment swept by the same square, one span per row.
+// Each covered pixel is written once, so cost follows the covered area.
+static void draw_line_exact(float x0, float y0, float x1, float y1)
+{
+    const float h = LINE_THICKNESS / 2 + 0.5f; // Square half-size around the line
+    float dx = x1 - x0;
+    float dy = y1 - y0;
+
+    // Pixel (px, py) is covered when its centre (px + 0.5, py + 0.5) lies
+    // within h of some point of the segment in both axes
+    int ymin = MAX((int)floorf(fminf(y0, y1) - h), 0);
+    int ymax = MIN((int)ceilf(fmaxf(y0, y1) + h), VIDEO_HEIGHT - 1);
+
+    for (int py = ymin; py <= ymax; py++)
+    {
+        float yc = py + 0.5f;
+        float ta = 0.0f, tb = 1.0f;
+
+        // Range of t where the segment is vertically within h of the row
+        if (fabsf(dy) > 1e-6f)
+        {
+            ta = (yc - h - y0) / dy;
+            tb = (yc + h - y0) / dy;
+            if (ta > tb)
+            {
+                float t = ta;
+                ta = tb;
+                tb = t;
+            }
+            ta = fmaxf(ta, 0.0f);
+            tb = fminf(tb, 1.0f);
+            if (ta > tb)
+                continue;
+        }
+        else if (fabsf(yc - y0) > h)
+        {
+            continue;
+        }
+
+        float xa = x0 + dx * ta;
+        float xb = x0 + dx * tb;
+        int sx0 = MAX((int)ceilf(fminf(xa, xb) - h - 0.5f), 0);
+        int sx1 = MIN((int)floorf(fmaxf(xa, xb) + h - 0.5f), VIDEO_WIDTH - 1);
+        if (sx0 <= sx1)
+            increment_span(py, sx0, sx1, LINE_INTENSITY);
+    }
+}
+
 void render_laser(float time)
 {
     const int CENTER_X = VIDEO_WIDTH / 2;
     const int CENTER_Y = VIDEO_HEIGHT / 2;
     const float BASE_RADIUS = 180.0f;
-#define LINE_THICKNESS 4 // Added thickness control
-
-    static const uint8_t color_remap[16] = {0, 0, 0, 0, 8, 8, 14, 14, 7, 7, 7, 7, 7, 7, 7, 7};
-    static uint8_t pixel_buffer[VIDEO_HEIGHT][VIDEO_WIDTH] = {0};
 
     time *= 15.0f;
-    memset(pixel_buffer, 0, sizeof(pixel_buffer));
+    if (options.laser_packed)
+        memset(packed_buffer, 0, sizeof(packed_buffer));
+    else
+        memset(pixel_buffer, 0, sizeof(pixel_buffer));
 
     for (float i = 0; i < 24.0f; i += 0.25f)
     {
@@ -43,32 +216,16 @@ void render_laser(float time)
         float x1 = CENTER_X + cosf(angle1) * BASE_RADIUS;
         float y1 = CENTER_Y + sinf(angle1) * BASE_RADIUS;
 
-        float dx = (x1 - x0) / 128.0f;
-        float dy = (y1 - y0) / 128.0f;
-
-        float x = x0, y = y0;
-        for (int j = 0; j < 128; j++)
-        {
-            int ix = (int)x;
-            int iy = (int)y;
-
-            // Draw thick points
-            for (int tx = -LINE_THICKNESS / 2; tx <= LINE_THICKNESS / 2; tx++)
-            {
-                for (int ty = -LINE_THICKNESS / 2; ty <= LINE_THICKNESS / 2; ty++)
-                {
-                    int nx = ix + tx;
-                    int ny = iy + ty;
-                    if (nx >= 0 && nx < VIDEO_WIDTH && ny >= 0 && ny < VIDEO_HEIGHT)
-                    {
-                        pixel_buffer[ny][nx] = (pixel_buffer[ny][nx] + 1) % 16;
-                    }
-                }
-            }
+        if (options.laser_sampled)
+            draw_line_sampled(x0, y0, x1, y1);
+        else
+            draw_line_exact(x0, y0, x1, y1);
+    }
 
-            x += dx;
-            y += dy;
-        }
+    if (options.laser_packed)
+    {
+        resolve_packed();
+        return;
     }
 
     for (int y = 0; y < VIDEO_HEIGHT; y++)
@@ -0,0 +1,325 @@
+#include "pibench.h"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#define SIZE_COUNT 17 // 4 KB to 256 MB in powers of two
+#define MIN_SIZE_LOG2 12
+#define PAGE_MODES 2
+#define SLOT_COUNT (PAGE_MODES * SIZE_COUNT)
+#define LINE_SIZE 64 // One node per cache line
+#define LOADS_PER_FRAME (1 << 18)
+#define SWEEP_TIME (DEMO_TIME * 0.9f) // Slack for slow chain builds at the largest sizes
+#define HUGE_ALIGN (2 << 20)
+
+// Chart geometry: log2 size across, log10 latency up
+#define CHART_X 80
+#define CHART_Y 152
+#define CHART_W 512
+#define CHART_H 272
+#define NS_LO 0.5
+#define NS_HI 500.0
+
+typedef enum {
+    PAGES_NORMAL,
+    PAGES_HUGE
+} page_mode_t;
+
+typedef struct {
+    uint8_t *base; // Mapping as returned by the allocator
+    uint8_t *nodes;
+    void *cursor; // Where the last frame's chase stopped
+    size_t size, mapped;
+    page_mode_t mode;
+} chase_buffer_t;
+
+static chase_buffer_t buffer;
+static const char *huge_name = "HUGE PAGES";
+static double loads_done[PAGE_MODES][SIZE_COUNT];
+static uint64_t usecs[PAGE_MODES][SIZE_COUNT];
+static int slot = -1;
+static float last_time = 0;
+static bool exported = false;
+static bool use_hugetlb = true;
+static char export_path[4200];
+
+static size_t slot_size(int index)
+{
+    return (size_t)1 << (MIN_SIZE_LOG2 + index);
+}
+
+// Largest working set to try: 256 MB, or a quarter of RAM on small boards
+static size_t max_working_set(void)
+{
+    size_t max = slot_size(SIZE_COUNT - 1);
+#ifdef __linux__
+    long pages = sysconf(_SC_PHYS_PAGES), page_size = sysconf(_SC_PAGESIZE);
+    if (pages > 0 && page_size > 0)
+        max = MIN(max, (size_t)pages * page_size / 4);
+#endif
+    return max;
+}
+
+static void free_buffer(void)
+{
+    if (!buffer.base)
+        return;
+#ifdef __linux__
+    // A failed unmap leaks the mapping; stop using hugetlbfs rather than
+    // drain its pool one page per working set
+    if (munmap(buffer.base, buffer.mapped) != 0 && buffer.mode == PAGES_HUGE)
+        use_hugetlb = false;
+#else
+    free(buffer.base);
+#endif
+    memset(&buffer, 0, sizeof(buffer));
+}
+
+// Normal pages are forced with MADV_NOHUGEPAGE. Huge pages come from the
+// hugetlbfs pool when one is reserved, else from transparent huge pages.
+static bool alloc_buffer(size_t size, page_mode_t mode)
+{
+    free_buffer();
+#ifdef __linux__
+    void *p = MAP_FAILED;
+    // hugetlb mappings are whole huge pages, and munmap needs that length
+    size_t mapped = (size + HUGE_ALIGN - 1) & ~(size_t)(HUGE_ALIGN - 1);
+    if (mode == PAGES_HUGE && use_hugetlb)
+    {
+        p = mmap(NULL, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        huge_name = "HUGE PAGES (HUGETLB)";
+    }
+    if (p == MAP_FAILED)
+    {
+        mapped = size + HUGE_ALIGN;
+        p = mmap(NULL, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED)
+            return false;
+        if (mode == PAGES_HUGE)
+            huge_name = "HUGE PAGES (THP)";
+    }
+    buffer.base = (uint8_t *)p;
+    buffer.mapped = mapped;
+    buffer.nodes = (uint8_t *)(((uintptr_t)p + HUGE_ALIGN - 1) & ~(uintptr_t)(HUGE_ALIGN - 1));
+    madvise(buffer.nodes, size, mode == PAGES_HUGE ? MADV_HUGEPAGE : MADV_NOHUGEPAGE);
+#else
+    if (mode == PAGES_HUGE)
+        return false;
+    buffer.base = buffer.nodes = (uint8_t *)malloc(size);
+    if (!buffer.base)
+        return false;
+#endif
+    buffer.size = size;
+    buffer.mode = mode;
+    return true;
+}
+
+// One random cycle through every line of the working set (Sattolo's
+// shuffle), so each load depends on the previous one and no prefetcher
+// can guess the next line
+static bool build_chain(size_t size)
+{
+    size_t lines = size / LINE_SIZE;
+    uint32_t *order = (uint32_t *)malloc(lines * sizeof(uint32_t));
+    if (!order)
+        return false;
+
+    uint64_t x = 0x9E3779B97F4A7C15ull ^ size;
+    for (size_t i = 0; i < lines; i++)
+        order[i] = (uint32_t)i;
+    for (size_t i = lines - 1; i > 0; i--)
+    {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        size_t j = x % i;
+        uint32_t t = order[i];
+        order[i] = order[j];
+        order[j] = t;
+    }
+
+    for (size_t i = 0; i < lines; i++)
+    {
+        size_t next = order[(i + 1) % lines];
+        *(void **)(buffer.nodes + (size_t)order[i] * LINE_SIZE) = buffer.nodes + next * LINE_SIZE;
+    }
+    buffer.cursor = buffer.nodes;
+    free(order);
+    return true;
+}
+
+static void *chase(void *p, int loads)
+{
+    for (int i = 0; i < loads; i += 8)
+    {
+        p = *(void **)p;
+        p = *(void **)p;
+        p = *(void **)p;
+        p = *(void **)p;
+        p = *(void **)p;
+        p = *(void **)p;
+        p = *(void **)p;
+        p = *(void **)p;
+    }
+    return p;
+}
+
+static double ns_per_load(int mode, int s)
+{
+    return loads_done[mode][s] > 0 ? usecs[mode][s] * 1000.0 / loads_done[mode][s] : 0;
+}
+
+static void export_curve(void)
+{
+    if (retro_base_directory[0])
+        snprintf(export_path, sizeof(export_path), "%s/pibench_latency.csv", retro_base_directory);
+    else
+        snprintf(export_path, sizeof(export_path), "pibench_latency.csv");
+
+    FILE *f = fopen(export_path, "w");
+    if (!f)
+    {
+        export_path[0] = '\0';
+        return;
+    }
+    fprintf(f, "bytes,ns_per_load_normal_pages,ns_per_load_huge_pages\n");
+    for (int s = 0; s < SIZE_COUNT; s++)
+        fprintf(f, "%zu,%.3f,%.3f\n", slot_size(s), ns_per_load(PAGES_NORMAL, s), ns_per_load(PAGES_HUGE, s));
+    fclose(f);
+}
+
+static float chart_x(int s)
+{
+    return CHART_X + s * (CHART_W / (float)(SIZE_COUNT - 1));
+}
+
+static float chart_y(double ns)
+{
+    double t = log10(fmin(fmax(ns, NS_LO), NS_HI) / NS_LO) / log10(NS_HI / NS_LO);
+    return CHART_Y + CHART_H - (float)(t * CHART_H);
+}
+
+static void draw_chart(void)
+{
+    static const uint32_t colors[PAGE_MODES] = {0xFF29ADFF, 0xFFFFA300};
+    static const double grid[] = {1, 2, 5, 10, 20, 50, 100, 200, 500};
+    uint32_t *pixels = (uint32_t *)frame_buf;
+    line_t lines[SIZE_COUNT + 16];
+    char buf[16];
+    int n = 0;
+
+    for (size_t g = 0; g < sizeof(grid) / sizeof(grid[0]); g++)
+    {
+        float y = chart_y(grid[g]);
+        lines[n++] = (line_t){CHART_X, y, CHART_X + CHART_W, y, 0xFF303030};
+        snprintf(buf, sizeof(buf), "%gNS", grid[g]);
+        draw_text_bg(CHART_X - 8 - (int)strlen(buf) * 8, (int)y - 4, buf, 0xFFC2C3C7);
+    }
+    draw_lines(lines, n);
+
+    for (int s = 0; s < SIZE_COUNT; s += 2)
+    {
+        size_t size = slot_size(s);
+        if (size >= (1 << 20))
+            snprintf(buf, sizeof(buf), "%zuM", size >> 20);
+        else
+            snprintf(buf, sizeof(buf), "%zuK", size >> 10);
+        draw_text_bg((int)chart_x(s) - (int)strlen(buf) * 4, CHART_Y + CHART_H + 8, buf, 0xFFC2C3C7);
+    }
+
+    for (int m = 0; m < PAGE_MODES; m++)
+    {
+        n = 0;
+        int prev = -1;
+        for (int s = 0; s < SIZE_COUNT; s++)
+        {
+            double ns = ns_per_load(m, s);
+            if (ns <= 0)
+                continue;
+            int px = (int)chart_x(s), py = (int)chart_y(ns);
+            for (int dy = -2; dy <= 2; dy++)
+                fill_span(pixels + (py + dy) * VIDEO_WIDTH + px - 2, 5, colors[m]);
+            if (prev >= 0)
+                lines[n++] = (line_t){chart_x(prev), chart_y(ns_per_load(m, prev)), px, py, colors[m]};
+            prev = s;
+        }
+        draw_lines(lines, n);
+
+        int lx = CHART_X + m * 200;
+        for (int dy = 0; dy < 8; dy++)
+            fill_span(pixels + (CHART_Y - 16 + dy) * VIDEO_WIDTH + lx, 8, colors[m]);
+        draw_text_bg(lx + 12, CHART_Y - 16, m == PAGES_NORMAL ? "NORMAL PAGES" : huge_name, 0xFFFFFFFF);
+    }
+}
+
+// Dependent loads through a random cycle of cache lines, from 4 KB to
+// 256 MB, first with normal pages and then with huge pages. Each working
+// set gets an equal share of the sweep, its chain is built on entry and
+// every frame chases LOADS_PER_FRAME pointers. The ns/load curve is drawn
+// on a log scale and written to pibench_latency.csv when the sweep ends.
+void render_latency(float time)
+{
+    static size_t max_size = 0;
+    char label[64];
+
+    if (time < last_time)
+    {
+        memset(loads_done, 0, sizeof(loads_done));
+        memset(usecs, 0, sizeof(usecs));
+        free_buffer();
+        slot = -1;
+        exported = false;
+    }
+    last_time = time;
+
+    if (!max_size)
+        max_size = max_working_set();
+
+    // Step one slot at a time, so a slow build never skips a working set
+    int due = MIN((int)(time * SLOT_COUNT / SWEEP_TIME), SLOT_COUNT);
+    if (slot < due)
+    {
+        slot++;
+        if (slot < SLOT_COUNT)
+        {
+            page_mode_t mode = (page_mode_t)(slot / SIZE_COUNT);
+            size_t size = slot_size(slot % SIZE_COUNT);
+            if (size > max_size || !alloc_buffer(size, mode) || !build_chain(size))
+                free_buffer();
+        }
+        else
+        {
+            free_buffer();
+            export_curve();
+            exported = true;
+        }
+    }
+
+    if (slot < SLOT_COUNT && buffer.nodes)
+    {
+        int mode = slot / SIZE_COUNT, s = slot % SIZE_COUNT;
+        uint64_t t0 = get_time_usec();
+        buffer.cursor = chase(buffer.cursor, LOADS_PER_FRAME);
+        uint64_t t1 = get_time_usec();
+
+        loads_done[mode][s] += LOADS_PER_FRAME;
+        usecs[mode][s] += t1 - t0;
+
+        // The overlay tracks the largest working set, i.e. DRAM latency
+        if (slot_size(s) * 2 > max_size)
+        {
+            snprintf(label, sizeof(label), "LOADS/S %zuMB (%s)", slot_size(s) >> 20,
+                     mode == PAGES_NORMAL ? "NORMAL PAGES" : "HUGE PAGES");
+            add_demo_stat(mode, label, LOADS_PER_FRAME, t1 - t0);
+        }
+    }
+
+    draw_chart();
+    if (exported && export_path[0])
+    {
+        size_t len = strlen(export_path);
+        snprintf(label, sizeof(label), "SAVED %s%.40s", len > 40 ? "..." : "", export_path + (len > 40 ? len - 40 : 0));
+        draw_text_bg(32, 456, label, 0xFFFFFFFF);
+    }
+}
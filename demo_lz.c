@@ -0,0 +1,413 @@
+#include "pibench.h"
+
+#define INPUT_SIZE (VIDEO_PIXELS * 4)
+#define INPUT_COUNT 5
+#define BLOCK_SIZE 65536
+#define BLOCK_COUNT ((INPUT_SIZE + BLOCK_SIZE - 1) / BLOCK_SIZE)
+#define BLOCK_BOUND (BLOCK_SIZE + BLOCK_SIZE / 255 + 16) // Worst case for incompressible data
+#define HASH_LOG2 12
+#define MIN_MATCH 4
+#define END_LITERALS 5 // Matches stop short of the block end so the decoder can finish on literals
+#define BAR_WIDTH 360
+#define MIN_RATE 1e6 // Bars are logarithmic from 1 MB/s, as incompressible data is far faster
+
+// Inputs from highly compressible to incompressible, plus a real frame
+typedef enum {
+    INPUT_RUNS,
+    INPUT_TEXT,
+    INPUT_SYMBOLS,
+    INPUT_RANDOM,
+    INPUT_FRAME
+} lz_input_t;
+
+static const char *input_names[INPUT_COUNT] = {"RUNS", "TEXT", "16 SYMBOLS", "RANDOM", "FRAME"};
+
+typedef enum {
+    OP_COMPRESS,
+    OP_DECOMPRESS,
+    OP_COUNT
+} lz_op_t;
+
+typedef struct {
+    const uint8_t *src;
+    uint8_t *packed;
+    uint8_t *out;
+    int packed_size[BLOCK_COUNT];
+    int out_size[BLOCK_COUNT];
+} lz_job_t;
+
+static uint8_t *inputs[INPUT_COUNT];
+static uint8_t *captured_frame = NULL;
+static uint8_t *packed = NULL, *unpacked = NULL;
+static bool inputs_ready = false;
+
+static double bytes_done[2][OP_COUNT][INPUT_COUNT];
+static uint64_t usecs[2][OP_COUNT][INPUT_COUNT];
+static double packed_bytes[INPUT_COUNT];
+static float last_time = 0;
+static int frame_counter = 0;
+
+static inline uint32_t read32(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t hash_sequence(uint32_t v)
+{
+    return (v * 2654435761u) >> (32 - HASH_LOG2);
+}
+
+static uint8_t *write_length(uint8_t *op, int len)
+{
+    for (; len >= 255; len -= 255)
+        *op++ = 255;
+    *op++ = (uint8_t)len;
+    return op;
+}
+
+// LZ77 with a 4-byte hash table and LZ4-style sequences: a token with
+// 4-bit literal and match lengths, extended by 255-runs, the literals and
+// a 16-bit offset. Returns the packed size, at most BLOCK_BOUND.
+static int lz_compress(const uint8_t *src, int n, uint8_t *dst)
+{
+    uint16_t table[1 << HASH_LOG2];
+    uint8_t *op = dst;
+    int ip = 0, anchor = 0;
+
+    memset(table, 0, sizeof(table));
+    while (ip + MIN_MATCH + END_LITERALS <= n)
+    {
+        uint32_t seq = read32(src + ip);
+        uint32_t h = hash_sequence(seq);
+        int ref = table[h];
+        table[h] = (uint16_t)ip;
+
+        if (ref >= ip || read32(src + ref) != seq)
+        {
+            // Step faster through data that keeps missing, as LZ4 does
+            ip += 1 + ((ip - anchor) >> 6);
+            continue;
+        }
+
+        int len = MIN_MATCH;
+        while (ip + len < n - END_LITERALS && src[ref + len] == src[ip + len])
+            len++;
+
+        int lit = ip - anchor;
+        uint8_t *token = op++;
+        *token = (uint8_t)((MIN(lit, 15) << 4) | MIN(len - MIN_MATCH, 15));
+        if (lit >= 15)
+            op = write_length(op, lit - 15);
+        memcpy(op, src + anchor, lit);
+        op += lit;
+        *op++ = (uint8_t)(ip - ref);
+        *op++ = (uint8_t)((ip - ref) >> 8);
+        if (len - MIN_MATCH >= 15)
+            op = write_length(op, len - MIN_MATCH - 15);
+
+        ip += len;
+        anchor = ip;
+    }
+
+    // Final sequence: literals only, no offset
+    int lit = n - anchor;
+    *op++ = (uint8_t)(MIN(lit, 15) << 4);
+    if (lit >= 15)
+        op = write_length(op, lit - 15);
+    memcpy(op, src + anchor, lit);
+    op += lit;
+    return (int)(op - dst);
+}
+
+static bool read_length(const uint8_t *src, int n, int *ip, int *len)
+{
+    uint8_t b;
+    do
+    {
+        if (*ip >= n)
+            return false;
+        b = src[(*ip)++];
+        *len += b;
+    } while (b == 255);
+    return true;
+}
+
+// Returns the unpacked size, or -1 if the input is malformed or would
+// overflow the capacity
+static int lz_decompress(const uint8_t *src, int n, uint8_t *dst, int capacity)
+{
+    int ip = 0, op = 0;
+
+    while (ip < n)
+    {
+        int token = src[ip++];
+        int lit = token >> 4;
+        if (lit == 15 && !read_length(src, n, &ip, &lit))
+            return -1;
+        if (lit > n - ip || lit > capacity - op)
+            return -1;
+        memcpy(dst + op, src + ip, lit);
+        ip += lit;
+        op += lit;
+        if (ip == n)
+            break;
+
+        if (ip + 2 > n)
+            return -1;
+        int offset = src[ip] | (src[ip + 1] << 8);
+        ip += 2;
+        int len = token & 15;
+        if (len == 15 && !read_length(src, n, &ip, &len))
+            return -1;
+        len += MIN_MATCH;
+        if (offset == 0 || offset > op || len > capacity - op)
+            return -1;
+
+        // Overlapping matches repeat the last offset bytes, so copy forwards
+        uint8_t *d = dst + op;
+        const uint8_t *s = d - offset;
+        if (offset >= len)
+            memcpy(d, s, len);
+        else
+            for (int i = 0; i < len; i++)
+                d[i] = s[i];
+        op += len;
+    }
+    return op;
+}
+
+static void compress_job(int index, void *arg)
+{
+    lz_job_t *job = (lz_job_t *)arg;
+    int offset = index * BLOCK_SIZE;
+    job->packed_size[index] = lz_compress(job->src + offset, MIN(BLOCK_SIZE, INPUT_SIZE - offset),
+                                          job->packed + index * BLOCK_BOUND);
+}
+
+static void decompress_job(int index, void *arg)
+{
+    lz_job_t *job = (lz_job_t *)arg;
+    int offset = index * BLOCK_SIZE;
+    job->out_size[index] = lz_decompress(job->packed + index * BLOCK_BOUND, job->packed_size[index],
+                                         job->out + offset, MIN(BLOCK_SIZE, INPUT_SIZE - offset));
+}
+
+// Called on entering the demo, while frame_buf still holds the previous
+// demo's last frame
+void lz_capture_frame(void)
+{
+    if (!captured_frame)
+        captured_frame = (uint8_t *)malloc(INPUT_SIZE);
+    if (captured_frame)
+        memcpy(captured_frame, frame_buf, INPUT_SIZE);
+}
+
+static void build_input(lz_input_t type, uint8_t *p)
+{
+    static const char *words[16] = {
+        "the ", "pixel ", "frame ", "buffer ", "of ", "and ", "core ", "render ",
+        "a ", "thread ", "to ", "vector ", "in ", "cache ", "line ", "is "
+    };
+    uint32_t seed = 12345 + type;
+
+    switch (type)
+    {
+        case INPUT_RUNS:
+            for (int i = 0; i < INPUT_SIZE;)
+            {
+                uint32_t h = hash32(seed++);
+                int len = MIN(4 + (int)(h % 200), INPUT_SIZE - i);
+                memset(p + i, (h >> 8) & 7, len);
+                i += len;
+            }
+            break;
+        case INPUT_TEXT:
+            for (int i = 0; i < INPUT_SIZE;)
+            {
+                const char *w = words[hash32(seed++) & 15];
+                for (; *w && i < INPUT_SIZE; w++)
+                    p[i++] = (uint8_t)*w;
+            }
+            break;
+        case INPUT_SYMBOLS:
+            for (int i = 0; i < INPUT_SIZE; i++)
+                p[i] = 'A' + (hash32(seed + i) & 15);
+            break;
+        case INPUT_RANDOM:
+            for (int i = 0; i < INPUT_SIZE; i++)
+                p[i] = (uint8_t)hash32(seed + i);
+            break;
+        default:
+            if (captured_frame)
+                memcpy(p, captured_frame, INPUT_SIZE);
+            else
+                memset(p, 0, INPUT_SIZE);
+            break;
+    }
+}
+
+static bool build_inputs(void)
+{
+    if (inputs_ready)
+        return true;
+
+    for (int i = 0; i < INPUT_COUNT; i++)
+    {
+        if (!inputs[i])
+            inputs[i] = (uint8_t *)malloc(INPUT_SIZE);
+        if (!inputs[i])
+            return false;
+    }
+    if (!packed)
+        packed = (uint8_t *)malloc(BLOCK_COUNT * BLOCK_BOUND);
+    if (!unpacked)
+        unpacked = (uint8_t *)malloc(INPUT_SIZE);
+    if (!packed || !unpacked)
+        return false;
+
+    for (int i = 0; i < INPUT_COUNT; i++)
+        build_input((lz_input_t)i, inputs[i]);
+    inputs_ready = true;
+    return true;
+}
+
+static void draw_rect(int x, int y, int w, int h, uint32_t color)
+{
+    uint32_t *pixels = (uint32_t *)frame_buf;
+    for (int row = y; row < y + h; row++)
+        fill_span(pixels + row * VIDEO_WIDTH + x, w, color);
+}
+
+static double get_rate(int threaded, int op, int input)
+{
+    return usecs[threaded][op][input] ? bytes_done[threaded][op][input] * 1000000.0 / usecs[threaded][op][input] : 0;
+}
+
+// Four bars per input: compress and decompress, one thread and the pool
+static void draw_chart(int threads)
+{
+    static const uint32_t colors[2][OP_COUNT] = {{0xFF29ADFF, 0xFFFF77A8}, {0xFF1D6FA8, 0xFFA8326E}};
+    char buf[64], rate[16];
+    int x = 32, y = 144;
+    double max_rate = 2 * MIN_RATE;
+
+    for (int t = 0; t < 2; t++)
+        for (int op = 0; op < OP_COUNT; op++)
+            for (int i = 0; i < INPUT_COUNT; i++)
+                max_rate = MAX(max_rate, get_rate(t, op, i));
+
+    for (int t = 0; t < 2; t++)
+    {
+        for (int op = 0; op < OP_COUNT; op++)
+        {
+            int lx = x + (t * 2 + op) * 144;
+            snprintf(buf, sizeof(buf), "%s %d", op == OP_COMPRESS ? "COMP" : "DECOMP", t ? threads : 1);
+            draw_rect(lx, y, 8, 8, colors[t][op]);
+            draw_text_bg(lx + 12, y, buf, 0xFFFFFFFF);
+        }
+    }
+    y += 16;
+
+    for (int i = 0; i < INPUT_COUNT; i++)
+    {
+        draw_text_bg(x, y, input_names[i], 0xFFFFFFFF);
+        if (packed_bytes[i] > 0)
+        {
+            snprintf(buf, sizeof(buf), "%.2f:1", (double)INPUT_SIZE / packed_bytes[i]);
+            draw_text_bg(x, y + 8, buf, 0xFFC2C3C7);
+        }
+
+        for (int t = 0; t < 2; t++)
+        {
+            for (int op = 0; op < OP_COUNT; op++)
+            {
+                int by = y + (t * 2 + op) * 10;
+                double r = get_rate(t, op, i);
+                int w = r > MIN_RATE ? (int)(BAR_WIDTH * log(r / MIN_RATE) / log(max_rate / MIN_RATE)) : 0;
+                if (w > 0)
+                    draw_rect(x + 112, by, w, 8, colors[t][op]);
+                if (r > 0)
+                {
+                    format_si(rate, sizeof(rate), r);
+                    draw_text_bg(x + 116 + w, by, rate, 0xFFFFFFFF);
+                }
+            }
+        }
+        y += 48;
+    }
+}
+
+// Block-based LZ77 compression and decompression of five 1.2 MB inputs:
+// long runs, word text, 16 random symbols, random bytes and the last frame
+// of the previous demo. Blocks are independent, so the pool splits them
+// across threads. The first half of the demo runs on one thread, the
+// second across the pool, and each frame round-trips one input.
+void render_lz(float time)
+{
+    char label[48];
+    int threads = thread_count();
+    int threaded = demo_variant(time, 2);
+
+    if (time < last_time)
+    {
+        memset(bytes_done, 0, sizeof(bytes_done));
+        memset(usecs, 0, sizeof(usecs));
+        memset(packed_bytes, 0, sizeof(packed_bytes));
+        inputs_ready = false;
+    }
+    last_time = time;
+
+    if (!build_inputs())
+    {
+        draw_text_bg(32, 144, "LZ: OUT OF MEMORY", 0xFFFFFFFF);
+        return;
+    }
+
+    int input = frame_counter++ % INPUT_COUNT;
+    lz_job_t job;
+    job.src = inputs[input];
+    job.packed = packed;
+    job.out = unpacked;
+
+    uint64_t t0 = get_time_usec();
+    if (threaded)
+        run_parallel(threads, BLOCK_COUNT, compress_job, &job);
+    else
+        for (int b = 0; b < BLOCK_COUNT; b++)
+            compress_job(b, &job);
+    uint64_t t1 = get_time_usec();
+    if (threaded)
+        run_parallel(threads, BLOCK_COUNT, decompress_job, &job);
+    else
+        for (int b = 0; b < BLOCK_COUNT; b++)
+            decompress_job(b, &job);
+    uint64_t t2 = get_time_usec();
+
+    int size = 0;
+    bool ok = true;
+    for (int b = 0; b < BLOCK_COUNT; b++)
+    {
+        size += job.packed_size[b];
+        ok &= job.out_size[b] == MIN(BLOCK_SIZE, INPUT_SIZE - b * BLOCK_SIZE);
+    }
+    ok = ok && memcmp(job.src, job.out, INPUT_SIZE) == 0;
+
+    packed_bytes[input] = size;
+    bytes_done[threaded][OP_COMPRESS][input] += INPUT_SIZE;
+    usecs[threaded][OP_COMPRESS][input] += t1 - t0;
+    bytes_done[threaded][OP_DECOMPRESS][input] += INPUT_SIZE;
+    usecs[threaded][OP_DECOMPRESS][input] += t2 - t1;
+
+    snprintf(label, sizeof(label), "COMPRESS B/S (%d THREAD%s)", threaded ? threads : 1,
+             threaded && threads > 1 ? "S" : "");
+    add_demo_stat(threaded * 2, label, INPUT_SIZE, t1 - t0);
+    snprintf(label, sizeof(label), "DECOMPRESS B/S (%d THREAD%s)", threaded ? threads : 1,
+             threaded && threads > 1 ? "S" : "");
+    add_demo_stat(threaded * 2 + 1, label, INPUT_SIZE, t2 - t1);
+
+    draw_chart(threads);
+    if (!ok)
+        draw_text_bg(32, 400, "LZ: ROUND TRIP MISMATCH", 0xFFFF004D);
+}
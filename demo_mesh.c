@@ -0,0 +1,480 @@
+#include "pibench.h"
+
+#define RINGS 32
+#define SIDES 16
+#define TORUS_VERTS (RINGS * SIDES)
+#define TORUS_TRIS (RINGS * SIDES * 2)
+#define TORI_PER_STRESS 8
+#define SUB_BITS 4 // 28.4 fixed-point screen coordinates
+#define SUB_ONE (1 << SUB_BITS)
+#define MAX_CLIP_VERTS 9
+
+#define TILE_WIDTH 64
+#define TILE_HEIGHT 48
+#define TILES_X (VIDEO_WIDTH / TILE_WIDTH)
+#define TILES_Y (VIDEO_HEIGHT / TILE_HEIGHT)
+#define TILE_COUNT (TILES_X * TILES_Y)
+
+typedef struct {
+    float x, y, z, w;
+    float shade;
+} clip_vertex_t;
+
+// Half-space triangle ready to rasterize. Edge values and depth are given
+// at the centre of pixel (0, 0); the top-left fill rule is folded into the
+// edge values so a pixel is inside when all three are >= 0.
+typedef struct {
+    int x0, y0, x1, y1; // Pixel bounding box, inclusive
+    int32_t edge[3];
+    int32_t step_x[3], step_y[3];
+    float z, dzdx, dzdy;
+    uint32_t color;
+} tri_t;
+
+typedef struct {
+    int *items;
+    int capacity;
+    int start[TILE_COUNT + 1];
+} tile_bins_t;
+
+static float torus_pos[TORUS_VERTS][3];
+static float torus_normal[TORUS_VERTS][3];
+static uint16_t torus_index[TORUS_TRIS][3];
+static bool torus_ready = false;
+
+static tri_t *tris = NULL;
+static int tri_count = 0;
+static int tri_capacity = 0;
+static bool tris_failed = false; // A triangle could not be stored this frame
+
+static float zbuf[VIDEO_PIXELS];
+static int tile_pixels[TILE_COUNT];
+
+static void build_torus(void)
+{
+    const float R = 1.0f, r = 0.4f;
+
+    for (int i = 0; i < RINGS; i++)
+    {
+        float t = i * 2.0f * M_PI / RINGS;
+        for (int j = 0; j < SIDES; j++)
+        {
+            float p = j * 2.0f * M_PI / SIDES;
+            int v = i * SIDES + j;
+            torus_pos[v][0] = (R + r * cosf(p)) * cosf(t);
+            torus_pos[v][1] = (R + r * cosf(p)) * sinf(t);
+            torus_pos[v][2] = r * sinf(p);
+            torus_normal[v][0] = cosf(p) * cosf(t);
+            torus_normal[v][1] = cosf(p) * sinf(t);
+            torus_normal[v][2] = sinf(p);
+        }
+    }
+
+    // Counter-clockwise seen from outside
+    int n = 0;
+    for (int i = 0; i < RINGS; i++)
+    {
+        for (int j = 0; j < SIDES; j++)
+        {
+            int a = i * SIDES + j;
+            int b = ((i + 1) % RINGS) * SIDES + j;
+            int c = ((i + 1) % RINGS) * SIDES + (j + 1) % SIDES;
+            int d = i * SIDES + (j + 1) % SIDES;
+            torus_index[n][0] = a, torus_index[n][1] = b, torus_index[n][2] = c, n++;
+            torus_index[n][0] = a, torus_index[n][1] = c, torus_index[n][2] = d, n++;
+        }
+    }
+    torus_ready = true;
+}
+
+// Signed distance to each clip-space frustum plane, negative outside
+static inline float plane_distance(const clip_vertex_t *v, int plane)
+{
+    switch (plane)
+    {
+        case 0: return v->w + v->x;
+        case 1: return v->w - v->x;
+        case 2: return v->w + v->y;
+        case 3: return v->w - v->y;
+        case 4: return v->w + v->z;
+        default: return v->w - v->z;
+    }
+}
+
+static inline int outcode(const clip_vertex_t *v)
+{
+    int code = 0;
+    for (int p = 0; p < 6; p++)
+    {
+        if (plane_distance(v, p) < 0.0f)
+            code |= 1 << p;
+    }
+    return code;
+}
+
+// Sutherland-Hodgman against the planes in `planes`, returns the new vertex count
+static int clip_polygon(clip_vertex_t *poly, int count, int planes)
+{
+    clip_vertex_t tmp[MAX_CLIP_VERTS];
+
+    for (int p = 0; p < 6 && count > 0; p++)
+    {
+        if (!(planes & (1 << p)))
+            continue;
+
+        int out = 0;
+        for (int i = 0; i < count; i++)
+        {
+            const clip_vertex_t *a = &poly[i];
+            const clip_vertex_t *b = &poly[(i + 1) % count];
+            float da = plane_distance(a, p), db = plane_distance(b, p);
+
+            if (da >= 0.0f)
+                tmp[out++] = *a;
+            if ((da >= 0.0f) != (db >= 0.0f) && out < MAX_CLIP_VERTS)
+            {
+                float t = da / (da - db);
+                tmp[out].x = a->x + (b->x - a->x) * t;
+                tmp[out].y = a->y + (b->y - a->y) * t;
+                tmp[out].z = a->z + (b->z - a->z) * t;
+                tmp[out].w = a->w + (b->w - a->w) * t;
+                tmp[out].shade = a->shade + (b->shade - a->shade) * t;
+                out++;
+            }
+        }
+        memcpy(poly, tmp, out * sizeof(clip_vertex_t));
+        count = out;
+    }
+    return count;
+}
+
+static tri_t *alloc_tri(void)
+{
+    if (tri_count == tri_capacity)
+    {
+        int capacity = tri_capacity ? tri_capacity * 2 : 4096;
+        tri_t *grown = (tri_t *)realloc(tris, capacity * sizeof(tri_t));
+        if (!grown)
+        {
+            tris_failed = true;
+            return NULL;
+        }
+        tris = grown;
+        tri_capacity = capacity;
+    }
+    return &tris[tri_count++];
+}
+
+// Perspective divide, viewport mapping, back-face culling and edge setup
+static void setup_triangle(const clip_vertex_t *v0, const clip_vertex_t *v1,
+                           const clip_vertex_t *v2, uint32_t base)
+{
+    const clip_vertex_t *v[3] = {v0, v1, v2};
+    int32_t px[3], py[3];
+    float sx[3], sy[3], sz[3];
+
+    for (int i = 0; i < 3; i++)
+    {
+        float inv_w = 1.0f / v[i]->w;
+        sx[i] = (v[i]->x * inv_w * 0.5f + 0.5f) * VIDEO_WIDTH;
+        sy[i] = (0.5f - v[i]->y * inv_w * 0.5f) * VIDEO_HEIGHT;
+        sz[i] = v[i]->z * inv_w * 0.5f + 0.5f;
+        px[i] = (int32_t)lrintf(sx[i] * SUB_ONE);
+        py[i] = (int32_t)lrintf(sy[i] * SUB_ONE);
+    }
+
+    // Counter-clockwise front faces turn clockwise once y points down
+    int64_t area = (int64_t)(px[1] - px[0]) * (py[2] - py[0]) -
+                   (int64_t)(py[1] - py[0]) * (px[2] - px[0]);
+    if (area >= 0)
+        return;
+
+    int32_t t;
+    float f;
+    t = px[1], px[1] = px[2], px[2] = t;
+    t = py[1], py[1] = py[2], py[2] = t;
+    f = sx[1], sx[1] = sx[2], sx[2] = f;
+    f = sy[1], sy[1] = sy[2], sy[2] = f;
+    f = sz[1], sz[1] = sz[2], sz[2] = f;
+
+    int minx = MIN(px[0], MIN(px[1], px[2]));
+    int maxx = MAX(px[0], MAX(px[1], px[2]));
+    int miny = MIN(py[0], MIN(py[1], py[2]));
+    int maxy = MAX(py[0], MAX(py[1], py[2]));
+
+    // Pixels whose centres fall inside the bounding box
+    tri_t *tri = alloc_tri();
+    if (!tri)
+        return;
+    tri->x0 = MAX((minx - SUB_ONE / 2 + SUB_ONE - 1) >> SUB_BITS, 0);
+    tri->y0 = MAX((miny - SUB_ONE / 2 + SUB_ONE - 1) >> SUB_BITS, 0);
+    tri->x1 = MIN((maxx - SUB_ONE / 2) >> SUB_BITS, VIDEO_WIDTH - 1);
+    tri->y1 = MIN((maxy - SUB_ONE / 2) >> SUB_BITS, VIDEO_HEIGHT - 1);
+    if (tri->x0 > tri->x1 || tri->y0 > tri->y1)
+    {
+        tri_count--;
+        return;
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        int a = i, b = (i + 1) % 3;
+        int32_t dx = px[b] - px[a], dy = py[b] - py[a];
+        bool top_left = dy < 0 || (dy == 0 && dx > 0);
+
+        tri->edge[i] = dx * (SUB_ONE / 2 - py[a]) - dy * (SUB_ONE / 2 - px[a]) - (top_left ? 0 : 1);
+        tri->step_x[i] = -dy * SUB_ONE;
+        tri->step_y[i] = dx * SUB_ONE;
+    }
+
+    float fa = (sx[1] - sx[0]) * (sy[2] - sy[0]) - (sy[1] - sy[0]) * (sx[2] - sx[0]);
+    tri->dzdx = ((sz[1] - sz[0]) * (sy[2] - sy[0]) - (sz[2] - sz[0]) * (sy[1] - sy[0])) / fa;
+    tri->dzdy = ((sz[2] - sz[0]) * (sx[1] - sx[0]) - (sz[1] - sz[0]) * (sx[2] - sx[0])) / fa;
+    tri->z = sz[0] + tri->dzdx * (0.5f - sx[0]) + tri->dzdy * (0.5f - sy[0]);
+
+    // Flat shading from the average vertex light
+    float shade = (v0->shade + v1->shade + v2->shade) * (1.0f / 3.0f);
+    int r = (int)(((base >> 16) & 0xFF) * shade);
+    int g = (int)(((base >> 8) & 0xFF) * shade);
+    int bl = (int)((base & 0xFF) * shade);
+    tri->color = 0xFF000000 | (r << 16) | (g << 8) | bl;
+}
+
+static void submit_triangle(const clip_vertex_t *v0, const clip_vertex_t *v1,
+                            const clip_vertex_t *v2, uint32_t base)
+{
+    int c0 = outcode(v0), c1 = outcode(v1), c2 = outcode(v2);
+
+    if (c0 & c1 & c2)
+        return;
+    if (!(c0 | c1 | c2))
+    {
+        setup_triangle(v0, v1, v2, base);
+        return;
+    }
+
+    clip_vertex_t poly[MAX_CLIP_VERTS] = {*v0, *v1, *v2};
+    int count = clip_polygon(poly, 3, c0 | c1 | c2);
+    for (int i = 1; i + 1 < count; i++)
+        setup_triangle(&poly[0], &poly[i], &poly[i + 1], base);
+}
+
+// Tori spread over a sphere that turns while the camera dollies in far
+// enough to push geometry through the screen edges and the near plane.
+// Returns the number of triangles submitted, or -1 when out of memory
+static int build_scene(float time)
+{
+    static const uint32_t pal[] = {
+        0xFFFF004D, 0xFFFFA300, 0xFFFFEC27, 0xFF00E436,
+        0xFF29ADFF, 0xFF83769C, 0xFFFF77A8, 0xFFFFCCAA
+    };
+    static clip_vertex_t verts[TORUS_VERTS];
+
+    const int count = TORI_PER_STRESS * options.stress;
+    const float scale = 0.8f / sqrtf((float)options.stress);
+    const float light[3] = {0.42f, 0.56f, 0.71f};
+
+    mat4_t proj = mat4_perspective(60.0f * M_PI / 180.0f, (float)VIDEO_WIDTH / VIDEO_HEIGHT, 0.1f, 100.0f);
+    mat4_t view = mat4_translate(0.0f, 0.0f, -(6.5f + 3.0f * cosf(time * 0.4f)));
+    mat4_t spin = mat4_rotate_y(time * 0.3f);
+    mat4_t tilt = mat4_rotate_x(0.4f);
+    mat4_t view_proj = mat4_mul(&proj, &view);
+    mat4_t scene = mat4_mul(&tilt, &spin);
+
+    tri_count = 0;
+    tris_failed = false;
+
+    for (int k = 0; k < count; k++)
+    {
+        // Fibonacci sphere placement
+        float y = 1.0f - (k + 0.5f) * 2.0f / count;
+        float ring = sqrtf(1.0f - y * y);
+        float a = k * 2.39996323f;
+        mat4_t place = mat4_translate(cosf(a) * ring * 3.5f, y * 3.5f, sinf(a) * ring * 3.5f);
+        mat4_t rx = mat4_rotate_x(time * (0.7f + 0.05f * (k % 7)) + k);
+        mat4_t rz = mat4_rotate_z(time * 0.5f + k * 0.3f);
+        mat4_t rot = mat4_mul(&rx, &rz);
+        mat4_t size = mat4_scale(scale);
+        mat4_t model = mat4_mul(&rot, &size);
+        model = mat4_mul(&place, &model);
+        model = mat4_mul(&scene, &model);
+        mat4_t mvp = mat4_mul(&view_proj, &model);
+
+        for (int i = 0; i < TORUS_VERTS; i++)
+        {
+            vec4_t p = mat4_transform(&mvp, torus_pos[i][0], torus_pos[i][1], torus_pos[i][2]);
+            const float *n = torus_normal[i];
+            float nx = model.m[0] * n[0] + model.m[1] * n[1] + model.m[2] * n[2];
+            float ny = model.m[4] * n[0] + model.m[5] * n[1] + model.m[6] * n[2];
+            float nz = model.m[8] * n[0] + model.m[9] * n[1] + model.m[10] * n[2];
+            float lambert = (nx * light[0] + ny * light[1] + nz * light[2]) / scale;
+            verts[i] = (clip_vertex_t){p.x, p.y, p.z, p.w, 0.2f + 0.8f * fmaxf(lambert, 0.0f)};
+        }
+
+        for (int i = 0; i < TORUS_TRIS; i++)
+        {
+            const uint16_t *idx = torus_index[i];
+            submit_triangle(&verts[idx[0]], &verts[idx[1]], &verts[idx[2]], pal[k % 8]);
+        }
+    }
+
+    return tris_failed ? -1 : count * TORUS_TRIS;
+}
+
+// Returns the number of pixels that passed the depth test
+static int raster_triangle(const tri_t *t, const clip_rect_t *clip)
+{
+    uint32_t *pixels = (uint32_t *)frame_buf;
+    int x0 = MAX(t->x0, clip->x0), x1 = MIN(t->x1, clip->x1);
+    int y0 = MAX(t->y0, clip->y0), y1 = MIN(t->y1, clip->y1);
+    int written = 0;
+
+    for (int y = y0; y <= y1; y++)
+    {
+        int32_t e0 = t->edge[0] + x0 * t->step_x[0] + y * t->step_y[0];
+        int32_t e1 = t->edge[1] + x0 * t->step_x[1] + y * t->step_y[1];
+        int32_t e2 = t->edge[2] + x0 * t->step_x[2] + y * t->step_y[2];
+        float zrow = t->z + t->dzdy * y;
+        float *depth = zbuf + y * VIDEO_WIDTH;
+        uint32_t *row = pixels + y * VIDEO_WIDTH;
+
+        for (int x = x0; x <= x1; x++)
+        {
+            if ((e0 | e1 | e2) >= 0)
+            {
+                float z = zrow + t->dzdx * x;
+                if (z < depth[x])
+                {
+                    depth[x] = z;
+                    row[x] = t->color;
+                    written++;
+                }
+            }
+            e0 += t->step_x[0];
+            e1 += t->step_x[1];
+            e2 += t->step_x[2];
+        }
+    }
+    return written;
+}
+
+static void clear_depth(const clip_rect_t *clip)
+{
+    for (int y = clip->y0; y <= clip->y1; y++)
+    {
+        float *depth = zbuf + y * VIDEO_WIDTH;
+        for (int x = clip->x0; x <= clip->x1; x++)
+            depth[x] = 1.0f;
+    }
+}
+
+static void tile_rect(int tile, clip_rect_t *clip)
+{
+    clip->x0 = (tile % TILES_X) * TILE_WIDTH;
+    clip->y0 = (tile / TILES_X) * TILE_HEIGHT;
+    clip->x1 = clip->x0 + TILE_WIDTH - 1;
+    clip->y1 = clip->y0 + TILE_HEIGHT - 1;
+}
+
+// Counting sort of triangle indices into every tile their bounding box touches
+static bool bin_triangles(tile_bins_t *bins)
+{
+    int fill[TILE_COUNT] = {0};
+
+    for (int i = 0; i < tri_count; i++)
+    {
+        const tri_t *t = &tris[i];
+        for (int ty = t->y0 / TILE_HEIGHT; ty <= t->y1 / TILE_HEIGHT; ty++)
+            for (int tx = t->x0 / TILE_WIDTH; tx <= t->x1 / TILE_WIDTH; tx++)
+                fill[ty * TILES_X + tx]++;
+    }
+
+    bins->start[0] = 0;
+    for (int b = 0; b < TILE_COUNT; b++)
+    {
+        bins->start[b + 1] = bins->start[b] + fill[b];
+        fill[b] = bins->start[b];
+    }
+
+    if (bins->capacity < bins->start[TILE_COUNT])
+    {
+        int *grown = (int *)realloc(bins->items, bins->start[TILE_COUNT] * sizeof(int));
+        if (!grown)
+            return false;
+        bins->items = grown;
+        bins->capacity = bins->start[TILE_COUNT];
+    }
+
+    for (int i = 0; i < tri_count; i++)
+    {
+        const tri_t *t = &tris[i];
+        for (int ty = t->y0 / TILE_HEIGHT; ty <= t->y1 / TILE_HEIGHT; ty++)
+            for (int tx = t->x0 / TILE_WIDTH; tx <= t->x1 / TILE_WIDTH; tx++)
+                bins->items[fill[ty * TILES_X + tx]++] = i;
+    }
+    return true;
+}
+
+static void draw_tile(int tile, void *arg)
+{
+    const tile_bins_t *bins = (const tile_bins_t *)arg;
+    clip_rect_t clip;
+    int written = 0;
+
+    tile_rect(tile, &clip);
+    clear_depth(&clip);
+    for (int i = bins->start[tile]; i < bins->start[tile + 1]; i++)
+        written += raster_triangle(&tris[bins->items[i]], &clip);
+    tile_pixels[tile] = written;
+}
+
+// Software 3D pipeline: per-vertex transform and lighting, homogeneous
+// clipping, half-space rasterization and a float depth buffer. The demo
+// time is split between drawing on one thread and drawing screen tiles
+// across the worker pool; both produce identical pixels.
+void render_mesh(float time)
+{
+    static tile_bins_t bins;
+    static const clip_rect_t screen = {0, 0, VIDEO_WIDTH - 1, VIDEO_HEIGHT - 1};
+    char label[40];
+    int threads = thread_count();
+    int variant = demo_variant(time, 2);
+    int pixels = 0;
+
+    if (!torus_ready)
+        build_torus();
+
+    uint64_t t0 = get_time_usec();
+    int submitted = build_scene(time);
+    if (submitted < 0 || (variant != 0 && !bin_triangles(&bins)))
+    {
+        draw_text_bg(32, 144, "MESH: OUT OF MEMORY", 0xFFFFFFFF);
+        return;
+    }
+    if (variant == 0)
+    {
+        clear_depth(&screen);
+        for (int i = 0; i < tri_count; i++)
+            pixels += raster_triangle(&tris[i], &screen);
+    }
+    else
+    {
+        run_parallel(threads, TILE_COUNT, draw_tile, &bins);
+        for (int i = 0; i < TILE_COUNT; i++)
+            pixels += tile_pixels[i];
+    }
+    uint64_t t1 = get_time_usec();
+
+    if (variant == 0)
+    {
+        add_demo_stat(0, "TRIS/S (1 THREAD)", submitted, t1 - t0);
+        add_demo_stat(1, "PIXELS/S (1 THREAD)", pixels, t1 - t0);
+    }
+    else
+    {
+        snprintf(label, sizeof(label), "TRIS/S (%d THREAD%s)", threads, threads > 1 ? "S" : "");
+        add_demo_stat(2, label, submitted, t1 - t0);
+        snprintf(label, sizeof(label), "PIXELS/S (%d THREAD%s)", threads, threads > 1 ? "S" : "");
+        add_demo_stat(3, label, pixels, t1 - t0);
+    }
+}
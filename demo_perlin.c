@@ -0,0 +1,243 @@
+#include "pibench.h"
+#include "simd.h"
+
+#define OCTAVES 4
+#define BASE_FREQ (1.0f / 96.0f)
+#define ROWS_PER_JOB 16
+
+// Lattice hash: one multiply per axis, then a finalizer per corner.
+// Only the top 4 bits are used to pick one of Perlin's 12 (+4) gradients.
+#define HASH_X 0x8DA6B343u
+#define HASH_Y 0xD8163841u
+#define HASH_Z 0xCB1AB31Fu
+#define HASH_MIX 0x2C1B3C6Du
+
+static inline uint32_t hash_mix(uint32_t h)
+{
+    h ^= h >> 15;
+    h *= HASH_MIX;
+    return h >> 28;
+}
+
+static inline float fade(float t)
+{
+    return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+}
+
+static inline float lerp(float a, float b, float t)
+{
+    return a + (b - a) * t;
+}
+
+// Improved-noise gradient selection (Perlin 2002)
+static inline float grad(uint32_t h, float x, float y, float z)
+{
+    float u = h < 8 ? x : y;
+    float v = h < 4 ? y : (h == 12 || h == 14 ? x : z);
+    return ((h & 1) ? -u : u) + ((h & 2) ? -v : v);
+}
+
+static float noise3(float x, float y, float z)
+{
+    float fx = floorf(x), fy = floorf(y), fz = floorf(z);
+    uint32_t hx0 = (uint32_t)(int32_t)fx * HASH_X, hx1 = hx0 + HASH_X;
+    uint32_t hy0 = (uint32_t)(int32_t)fy * HASH_Y, hy1 = hy0 + HASH_Y;
+    uint32_t hz0 = (uint32_t)(int32_t)fz * HASH_Z, hz1 = hz0 + HASH_Z;
+    x -= fx;
+    y -= fy;
+    z -= fz;
+
+    float u = fade(x), v = fade(y), w = fade(z);
+
+    float n000 = grad(hash_mix(hx0 ^ hy0 ^ hz0), x, y, z);
+    float n100 = grad(hash_mix(hx1 ^ hy0 ^ hz0), x - 1, y, z);
+    float n010 = grad(hash_mix(hx0 ^ hy1 ^ hz0), x, y - 1, z);
+    float n110 = grad(hash_mix(hx1 ^ hy1 ^ hz0), x - 1, y - 1, z);
+    float n001 = grad(hash_mix(hx0 ^ hy0 ^ hz1), x, y, z - 1);
+    float n101 = grad(hash_mix(hx1 ^ hy0 ^ hz1), x - 1, y, z - 1);
+    float n011 = grad(hash_mix(hx0 ^ hy1 ^ hz1), x, y - 1, z - 1);
+    float n111 = grad(hash_mix(hx1 ^ hy1 ^ hz1), x - 1, y - 1, z - 1);
+
+    float nx00 = lerp(n000, n100, u), nx10 = lerp(n010, n110, u);
+    float nx01 = lerp(n001, n101, u), nx11 = lerp(n011, n111, u);
+    return lerp(lerp(nx00, nx10, v), lerp(nx01, nx11, v), w);
+}
+
+// Fractal sum normalized to roughly [0, 1], shaded deep blue to white
+static inline uint32_t shade(float n)
+{
+    float t = fminf(fmaxf(n * 0.9f + 0.5f, 0.0f), 1.0f);
+    int r = (int)(t * t * 255.0f);
+    int g = (int)(t * 255.0f);
+    int b = (int)((0.35f + 0.65f * t) * 255.0f);
+    return 0xFF000000 | (r << 16) | (g << 8) | b;
+}
+
+static void render_rows_scalar(int y0, int y1, float time)
+{
+    uint32_t *pixels = (uint32_t *)frame_buf;
+    float z = time * 0.4f;
+    float drift = time * 24.0f;
+
+    for (int y = y0; y < y1; y++)
+    {
+        for (int x = 0; x < VIDEO_WIDTH; x++)
+        {
+            float freq = BASE_FREQ, amp = 0.5f, sum = 0.0f;
+            for (int o = 0; o < OCTAVES; o++)
+            {
+                sum += amp * noise3((x + drift) * freq, y * freq, z);
+                freq *= 2.0f;
+                amp *= 0.5f;
+            }
+            pixels[y * VIDEO_WIDTH + x] = shade(sum);
+        }
+    }
+}
+
+static inline v4i hash_mix4(v4i h)
+{
+    h = v4i_xor(h, v4i_shr(h, 15));
+    h = v4i_mul(h, v4i_set1((int32_t)HASH_MIX));
+    return v4i_shr(h, 28);
+}
+
+static inline v4f fade4(v4f t)
+{
+    v4f p = v4f_madd(t, v4f_set1(6.0f), v4f_set1(-15.0f));
+    p = v4f_madd(t, p, v4f_set1(10.0f));
+    return v4f_mul(v4f_mul(v4f_mul(t, t), t), p);
+}
+
+static inline v4f lerp4(v4f a, v4f b, v4f t)
+{
+    return v4f_madd(v4f_sub(b, a), t, a);
+}
+
+static inline v4f grad4(v4i h, v4f x, v4f y, v4f z)
+{
+    v4i xz = v4i_or(v4i_cmpeq(h, v4i_set1(12)), v4i_cmpeq(h, v4i_set1(14)));
+    v4f u = v4f_select(v4i_cmplt(h, v4i_set1(8)), x, y);
+    v4f v = v4f_select(v4i_cmplt(h, v4i_set1(4)), y, v4f_select(xz, x, z));
+
+    // Bits 0 and 1 of the hash flip the signs of u and v
+    u = v4i_as_v4f(v4i_xor(v4f_as_v4i(u), v4i_shl(h, 31)));
+    v = v4i_as_v4f(v4i_xor(v4f_as_v4i(v), v4i_shl(v4i_shr(h, 1), 31)));
+    return v4f_add(u, v);
+}
+
+SIMD_KERNEL v4f noise3x4(v4f x, v4f y, v4f z)
+{
+    const v4f one = v4f_set1(1.0f);
+    v4f fx = v4f_floor(x), fy = v4f_floor(y), fz = v4f_floor(z);
+    v4i hx0 = v4i_mul(v4f_to_v4i(fx), v4i_set1((int32_t)HASH_X));
+    v4i hy0 = v4i_mul(v4f_to_v4i(fy), v4i_set1((int32_t)HASH_Y));
+    v4i hz0 = v4i_mul(v4f_to_v4i(fz), v4i_set1((int32_t)HASH_Z));
+    v4i hx1 = v4i_add(hx0, v4i_set1((int32_t)HASH_X));
+    v4i hy1 = v4i_add(hy0, v4i_set1((int32_t)HASH_Y));
+    v4i hz1 = v4i_add(hz0, v4i_set1((int32_t)HASH_Z));
+    x = v4f_sub(x, fx);
+    y = v4f_sub(y, fy);
+    z = v4f_sub(z, fz);
+    v4f x1 = v4f_sub(x, one), y1 = v4f_sub(y, one), z1 = v4f_sub(z, one);
+
+    v4f u = fade4(x), v = fade4(y), w = fade4(z);
+
+    v4i h00 = v4i_xor(hy0, hz0), h10 = v4i_xor(hy1, hz0);
+    v4i h01 = v4i_xor(hy0, hz1), h11 = v4i_xor(hy1, hz1);
+
+    v4f n000 = grad4(hash_mix4(v4i_xor(hx0, h00)), x, y, z);
+    v4f n100 = grad4(hash_mix4(v4i_xor(hx1, h00)), x1, y, z);
+    v4f n010 = grad4(hash_mix4(v4i_xor(hx0, h10)), x, y1, z);
+    v4f n110 = grad4(hash_mix4(v4i_xor(hx1, h10)), x1, y1, z);
+    v4f n001 = grad4(hash_mix4(v4i_xor(hx0, h01)), x, y, z1);
+    v4f n101 = grad4(hash_mix4(v4i_xor(hx1, h01)), x1, y, z1);
+    v4f n011 = grad4(hash_mix4(v4i_xor(hx0, h11)), x, y1, z1);
+    v4f n111 = grad4(hash_mix4(v4i_xor(hx1, h11)), x1, y1, z1);
+
+    v4f nx00 = lerp4(n000, n100, u), nx10 = lerp4(n010, n110, u);
+    v4f nx01 = lerp4(n001, n101, u), nx11 = lerp4(n011, n111, u);
+    return lerp4(lerp4(nx00, nx10, v), lerp4(nx01, nx11, v), w);
+}
+
+SIMD_KERNEL v4i shade4(v4f n)
+{
+    v4f t = v4f_madd(n, v4f_set1(0.9f), v4f_set1(0.5f));
+    t = v4f_min(v4f_max(t, v4f_set1(0.0f)), v4f_set1(1.0f));
+    v4f s = v4f_set1(255.0f);
+    v4i r = v4f_to_v4i(v4f_mul(v4f_mul(t, t), s));
+    v4i g = v4f_to_v4i(v4f_mul(t, s));
+    v4i b = v4f_to_v4i(v4f_mul(v4f_madd(t, v4f_set1(0.65f), v4f_set1(0.35f)), s));
+    return v4i_or(v4i_or(v4i_set1((int32_t)0xFF000000), v4i_shl(r, 16)), v4i_or(v4i_shl(g, 8), b));
+}
+
+SIMD_KERNEL void render_rows_simd_body(int y0, int y1, float time)
+{
+    int32_t *pixels = (int32_t *)frame_buf;
+    v4f z = v4f_set1(time * 0.4f);
+    float drift = time * 24.0f;
+
+    for (int y = y0; y < y1; y++)
+    {
+        for (int x = 0; x < VIDEO_WIDTH; x += 4)
+        {
+            v4f px = v4f_set(x + drift, x + 1 + drift, x + 2 + drift, x + 3 + drift);
+            v4f py = v4f_set1((float)y);
+            v4f freq = v4f_set1(BASE_FREQ);
+            v4f amp = v4f_set1(0.5f);
+            v4f sum = v4f_set1(0.0f);
+
+            for (int o = 0; o < OCTAVES; o++)
+            {
+                v4f n = noise3x4(v4f_mul(px, freq), v4f_mul(py, freq), z);
+                sum = v4f_madd(amp, n, sum);
+                freq = v4f_add(freq, freq);
+                amp = v4f_mul(amp, v4f_set1(0.5f));
+            }
+            v4i_store(pixels + y * VIDEO_WIDTH + x, shade4(sum));
+        }
+    }
+}
+
+SIMD_CLONES(render_rows_simd, (int y0, int y1, float time), (y0, y1, time))
+
+static void render_rows_simd(int y0, int y1, float time)
+{
+    SIMD_CALL(render_rows_simd, (y0, y1, time));
+}
+
+static void render_job(int index, void *arg)
+{
+    int y0 = index * ROWS_PER_JOB;
+    render_rows_simd(y0, MIN(y0 + ROWS_PER_JOB, VIDEO_HEIGHT), *(const float *)arg);
+}
+
+// Animated 3D gradient noise, several octaves per pixel. The demo time is
+// split between the scalar, SIMD and multithreaded SIMD kernels.
+void render_perlin(float time)
+{
+    char label[40];
+    int threads = thread_count();
+    int variant = demo_variant(time, 3);
+
+    uint64_t t0 = get_time_usec();
+    switch (variant)
+    {
+        case 0:
+            render_rows_scalar(0, VIDEO_HEIGHT, time);
+            snprintf(label, sizeof(label), "PIXELS/S (SCALAR)");
+            break;
+        case 1:
+            render_rows_simd(0, VIDEO_HEIGHT, time);
+            snprintf(label, sizeof(label), "PIXELS/S (%s)", simd_level_name());
+            break;
+        default:
+            run_parallel(threads, (VIDEO_HEIGHT + ROWS_PER_JOB - 1) / ROWS_PER_JOB, render_job, &time);
+            snprintf(label, sizeof(label), "PIXELS/S (%s, %d THREAD%s)", simd_level_name(), threads,
+                     threads > 1 ? "S" : "");
+            break;
+    }
+    uint64_t t1 = get_time_usec();
+
+    add_demo_stat(variant, label, VIDEO_PIXELS, t1 - t0);
+}
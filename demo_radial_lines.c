@@ -1,39 +1,21 @@
 #include "pibench.h"
 
-// Bresenham's line algorithm implementation
-static void draw_line(float x0, float y0, float x1, float y1, uint32_t color)
-{
-    int ix0 = (int)x0, iy0 = (int)y0;
-    int ix1 = (int)x1, iy1 = (int)y1;
+#define BAND_COUNT 16
+#define BAND_HEIGHT (VIDEO_HEIGHT / BAND_COUNT)
 
-    int dx = abs(ix1 - ix0), sx = ix0 < ix1 ? 1 : -1;
-    int dy = -abs(iy1 - iy0), sy = iy0 < iy1 ? 1 : -1;
-    int err = dx + dy, e2;
+// Lines sorted by horizontal screen band; a line is listed in every band it crosses
+typedef struct {
+    line_t *items;
+    int capacity;
+    int start[BAND_COUNT + 1];
+} band_bins_t;
 
-    while (1)
-    {
-        if (ix0 >= 0 && ix0 < VIDEO_WIDTH && iy0 >= 0 && iy0 < VIDEO_HEIGHT)
-        {
-            ((uint32_t *)frame_buf)[iy0 * VIDEO_WIDTH + ix0] = color;
-        }
+static line_t *lines = NULL;
+static int lines_capacity = 0;
 
-        if (ix0 == ix1 && iy0 == iy1)
-            break;
-        e2 = 2 * err;
-        if (e2 >= dy)
-        {
-            err += dy;
-            ix0 += sx;
-        }
-        if (e2 <= dx)
-        {
-            err += dx;
-            iy0 += sy;
-        }
-    }
-}
-
-void render_radial_lines(float time)
+// Collect the visible ring segments for this frame, rotated by spin radians.
+// The stress level adds rings between the original ones.
+static int build_lines(float time, float spin)
 {
     const float SCALE = 5.0f; // 128 -> 640 (5x scale)
     const int CENTER_X = VIDEO_WIDTH / 2;
@@ -51,7 +33,20 @@ void render_radial_lines(float time)
         0xFFFFCCAA   // Peach     (15)
     };
 
-    for(int r = 4; r <= 128; r += 4) {
+    const int rings = 32 * options.stress;
+    int count = 0;
+
+    if (lines_capacity < rings * 7)
+    {
+        line_t *grown = (line_t *)realloc(lines, rings * 7 * sizeof(line_t));
+        if (!grown)
+            return 0;
+        lines = grown;
+        lines_capacity = rings * 7;
+    }
+
+    for(int ring = 1; ring <= rings; ring++) {
+        float r = ring * 4.0f / options.stress;
         for(float i = 0.0f; i < 1.75f; i += 0.25f) {
             float q = fmodf(time * (1.0f + r/32.0f) / 8.0f, 1.0f);
             float v0 = fmaxf(fminf((q - i) * 4.0f, 1.0f), 0.0f);
@@ -60,13 +55,13 @@ void render_radial_lines(float time)
             if(v1 > v0) {
                 // Calculate start position
                 float a = i - 0.125f;
-                float x = CENTER_X + cosf(a * M_PI * 2) * r * 0.71f * SCALE;
-                float y = CENTER_Y + sinf(a * M_PI * 2) * r * 0.71f * SCALE;
+                float x = CENTER_X + cosf(a * M_PI * 2 + spin) * r * 0.71f * SCALE;
+                float y = CENTER_Y + sinf(a * M_PI * 2 + spin) * r * 0.71f * SCALE;
 
                 // Calculate direction vector
                 a += 0.375f; // 3/8 converted to 0.375
-                float u = cosf(a * M_PI * 2);
-                float v = sinf(a * M_PI * 2);
+                float u = cosf(a * M_PI * 2 + spin);
+                float v = sinf(a * M_PI * 2 + spin);
 
                 // Calculate line endpoints
                 float x0 = x + u * v0 * r * SCALE;
@@ -75,9 +70,108 @@ void render_radial_lines(float time)
                 float y1 = y + v * v1 * r * SCALE;
 
                 // Select color from palette
-                int color_idx = 8 + ((r/4) % 8);
-                draw_line(x0, y0, x1, y1, pal[color_idx - 8]);
+                int color_idx = 8 + ((int)(r/4) % 8);
+                lines[count++] = (line_t){x0, y0, x1, y1, pal[color_idx - 8]};
             }
         }
     }
-}
\ No newline at end of file
+
+    return count;
+}
+
+void render_radial_lines(float time)
+{
+    int count = build_lines(time, 0.0f);
+
+    draw_lines(lines, count);
+}
+
+// Same scene with anti-aliased lines blended into the frame buffer. The
+// scene slowly rotates so lines cover every slope, not just the axes.
+void render_radial_lines_aa(float time)
+{
+    int count = build_lines(time, time * 0.2f);
+
+    draw_lines_aa(lines, count);
+}
+
+// Rows a line can touch, as a band range (empty if b0 > b1)
+static void band_range(const line_t *line, int *b0, int *b1)
+{
+    int y0 = (int)fmaxf(fminf(line->y0, VIDEO_HEIGHT), -1.0f);
+    int y1 = (int)fmaxf(fminf(line->y1, VIDEO_HEIGHT), -1.0f);
+    int lo = MAX(MIN(y0, y1), 0);
+    int hi = MIN(MAX(y0, y1), VIDEO_HEIGHT - 1);
+
+    *b0 = lo / BAND_HEIGHT;
+    *b1 = hi >= lo ? hi / BAND_HEIGHT : *b0 - 1;
+}
+
+// Returns false if the bins could not grow to hold this frame's lines
+static bool bin_lines(const line_t *src, int count, band_bins_t *bins)
+{
+    int fill[BAND_COUNT] = {0};
+    int b0, b1;
+
+    for (int i = 0; i < count; i++)
+    {
+        band_range(&src[i], &b0, &b1);
+        for (int b = b0; b <= b1; b++)
+            fill[b]++;
+    }
+
+    bins->start[0] = 0;
+    for (int b = 0; b < BAND_COUNT; b++)
+    {
+        bins->start[b + 1] = bins->start[b] + fill[b];
+        fill[b] = bins->start[b];
+    }
+
+    if (bins->capacity < bins->start[BAND_COUNT])
+    {
+        line_t *grown = (line_t *)realloc(bins->items, bins->start[BAND_COUNT] * sizeof(line_t));
+        if (!grown)
+            return false;
+        bins->items = grown;
+        bins->capacity = bins->start[BAND_COUNT];
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        band_range(&src[i], &b0, &b1);
+        for (int b = b0; b <= b1; b++)
+            bins->items[fill[b]++] = src[i];
+    }
+    return true;
+}
+
+static void draw_band(int band, void *arg)
+{
+    const band_bins_t *bins = (const band_bins_t *)arg;
+    clip_rect_t clip = {0, band * BAND_HEIGHT, VIDEO_WIDTH - 1, (band + 1) * BAND_HEIGHT - 1};
+
+    draw_lines_clipped(bins->items + bins->start[band],
+                       bins->start[band + 1] - bins->start[band], &clip);
+}
+
+// Draw the scene serially, then again with bands spread across the worker
+// pool. Both passes produce identical pixels; each one reports lines/second.
+void render_radial_lines_mt(float time)
+{
+    static band_bins_t bins;
+    char label[40];
+    int threads = thread_count();
+    int count = build_lines(time, 0.0f);
+
+    uint64_t t0 = get_time_usec();
+    draw_lines(lines, count);
+    uint64_t t1 = get_time_usec();
+    if (!bin_lines(lines, count, &bins))
+        return;
+    run_parallel(threads, BAND_COUNT, draw_band, &bins);
+    uint64_t t2 = get_time_usec();
+
+    add_demo_stat(0, "LINES/S (1 THREAD)", count, t1 - t0);
+    snprintf(label, sizeof(label), "LINES/S (%d THREAD%s)", threads, threads > 1 ? "S" : "");
+    add_demo_stat(1, label, count, t2 - t1);
+}
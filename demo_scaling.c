@@ -0,0 +1,224 @@
+#include "pibench.h"
+
+#define STEP_TIME 1.0f      // Seconds per demo and thread count
+#define WARM_UP_TIME 0.25f  // Start of each step that is left out of the rate
+#define MAX_STEPS 32
+
+// Chart geometry on the results screen: threads across, speedup up
+#define CHART_X 352
+#define CHART_Y 264
+#define CHART_W 256
+#define CHART_H 160
+
+typedef struct {
+    const char *name;
+    void (*render)(float);
+    int slot; // Stat slot of the multithreaded variant
+} scaling_demo_t;
+
+static const scaling_demo_t demos[] = {
+    {"RADIAL LINES", render_radial_lines_mt, 1},
+    {"PERLIN", render_perlin, 2},
+    {"SGEMM", render_sgemm, 5},
+    {"FFT", render_fft, 4},
+    {"MESH", render_mesh, 2},
+    {"VERTEX", render_vertex, 4},
+    {"TEXTURE", render_texture, 6},
+    {"TILEMAP", render_tilemap, 2},
+    {"SPRITES", render_sprites, 2},
+    {"COMPOSITE", render_composite, 3},
+    {"LZ", render_lz, 2},
+};
+
+#define DEMO_COUNT (int)(sizeof(demos) / sizeof(demos[0]))
+
+static const uint32_t colors[DEMO_COUNT] = {
+    0xFFFF004D, 0xFFFFA300, 0xFFFFEC27, 0xFF00E436, 0xFF29ADFF, 0xFF83769C,
+    0xFFFF77A8, 0xFFFFCCAA, 0xFFAB5236, 0xFF008751, 0xFFC2C3C7,
+};
+
+static int steps[MAX_STEPS]; // Thread counts to measure, ascending
+static int step_count = 0;
+static double rates[DEMO_COUNT][MAX_STEPS];
+static bool has_results = false;
+static int current_step = -1;
+static bool measuring = false;
+static float last_time = 0;
+
+// Every count up to 8 threads, then coarser steps so big machines still
+// finish in a few minutes; the full pool is always the last step
+static void plan_steps(void)
+{
+    int max = thread_count();
+    step_count = 0;
+    for (int k = 1; k < max && step_count < MAX_STEPS - 1; k += MAX(k / 4, 1))
+        steps[step_count++] = k;
+    steps[step_count++] = max;
+}
+
+float scaling_duration(void)
+{
+    if (!step_count)
+        plan_steps();
+    return DEMO_COUNT * step_count * STEP_TIME;
+}
+
+static double speedup(int d, int s)
+{
+    return rates[d][0] > 0 ? rates[d][s] / rates[d][0] : 0;
+}
+
+// Least-squares fit of Amdahl's law, 1/S(k) = f + (1 - f)/k, for the serial
+// fraction f. Returns -1 when there is nothing to fit.
+static double serial_fraction(int d)
+{
+    double num = 0, den = 0;
+    for (int s = 1; s < step_count; s++)
+    {
+        double sp = speedup(d, s), x = 1.0 - 1.0 / steps[s];
+        if (sp <= 0)
+            continue;
+        num += (1.0 / sp - 1.0 / steps[s]) * x;
+        den += x * x;
+    }
+    return den > 0 ? fmin(fmax(num / den, 0.0), 1.0) : -1;
+}
+
+// Runs the multithreaded variant of each parallel demo for STEP_TIME at
+// every planned thread count. The demo sees a fresh clock per step, so its
+// own tables and warm-up restart, and the first WARM_UP_TIME of each step
+// is dropped from the rate.
+void render_scaling(float time)
+{
+    char buf[64];
+
+    if (time < last_time || !step_count)
+    {
+        plan_steps();
+        memset(rates, 0, sizeof(rates));
+        has_results = false;
+        current_step = -1;
+    }
+    last_time = time;
+
+    int step = MIN((int)(time / STEP_TIME), DEMO_COUNT * step_count - 1);
+    int d = step / step_count, s = step % step_count;
+    float local_time = time - step * STEP_TIME;
+
+    if (step != current_step)
+    {
+        current_step = step;
+        measuring = false;
+        reset_demo_stats();
+    }
+    else if (!measuring && local_time >= WARM_UP_TIME)
+    {
+        measuring = true;
+        reset_demo_stats();
+    }
+
+    set_thread_limit(steps[s]);
+    force_last_variant(true);
+    demos[d].render(local_time);
+    force_last_variant(false);
+    set_thread_limit(0);
+
+    // A step too slow to leave its warm-up keeps the warm-up rate
+    double rate = get_demo_stat(demos[d].slot);
+    if (rate > 0)
+    {
+        rates[d][s] = rate;
+        has_results = true;
+    }
+
+    snprintf(buf, sizeof(buf), "SCALING: %s ON %d OF %d THREADS", demos[d].name, steps[s], steps[step_count - 1]);
+    draw_text_bg(32, VIDEO_HEIGHT - 24, buf, 0xFFFFFFFF);
+}
+
+static float chart_x(int threads)
+{
+    return CHART_X + (threads - 1) * (CHART_W / (float)(steps[step_count - 1] - 1));
+}
+
+static float chart_y(double speedup)
+{
+    return CHART_Y + CHART_H - (float)(fmin(speedup / steps[step_count - 1], 1.0) * CHART_H);
+}
+
+static void draw_chart(void)
+{
+    uint32_t *pixels = (uint32_t *)frame_buf;
+    int max = steps[step_count - 1];
+    line_t lines[MAX_STEPS + 8];
+    char buf[16];
+    int n = 0;
+
+    for (int g = 1; g <= 4; g++)
+    {
+        float y = chart_y(max * g / 4.0);
+        lines[n++] = (line_t){CHART_X, y, CHART_X + CHART_W, y, 0xFF303030};
+        snprintf(buf, sizeof(buf), "%.3gX", max * g / 4.0);
+        draw_text_bg(CHART_X - 8 - (int)strlen(buf) * 8, (int)y - 4, buf, 0xFFC2C3C7);
+    }
+    lines[n++] = (line_t){CHART_X, CHART_Y + CHART_H, CHART_X + CHART_W, CHART_Y + CHART_H, 0xFF303030};
+    lines[n++] = (line_t){chart_x(1), chart_y(1), chart_x(max), chart_y(max), 0xFF5F574F}; // Ideal scaling
+    draw_lines(lines, n);
+
+    for (int s = 0; s < step_count; s += (step_count > 8) ? 2 : 1)
+    {
+        snprintf(buf, sizeof(buf), "%d", steps[s]);
+        draw_text_bg((int)chart_x(steps[s]) - (int)strlen(buf) * 4, CHART_Y + CHART_H + 8, buf, 0xFFC2C3C7);
+    }
+    draw_text_bg(CHART_X + CHART_W / 2 - 28, CHART_Y + CHART_H + 20, "THREADS", 0xFFC2C3C7);
+
+    for (int d = 0; d < DEMO_COUNT; d++)
+    {
+        n = 0;
+        int prev = -1;
+        for (int s = 0; s < step_count; s++)
+        {
+            double sp = speedup(d, s);
+            if (sp <= 0)
+                continue;
+            int px = (int)chart_x(steps[s]), py = (int)chart_y(sp);
+            for (int dy = -1; dy <= 1; dy++)
+                fill_span(pixels + (py + dy) * VIDEO_WIDTH + px - 1, 3, colors[d]);
+            if (prev >= 0)
+                lines[n++] = (line_t){chart_x(steps[prev]), chart_y(speedup(d, prev)), px, py, colors[d]};
+            prev = s;
+        }
+        draw_lines(lines, n);
+    }
+}
+
+// Speedup and efficiency at the full pool plus the fitted serial fraction
+// for each demo, next to the speedup curves. Draws nothing until a sweep
+// has produced results.
+void draw_scaling_results(int x, int y)
+{
+    char buf[64], serial[16];
+
+    if (!has_results)
+        return;
+
+    int max = steps[step_count - 1];
+    snprintf(buf, sizeof(buf), "MULTI-CORE SCALING, 1-%d THREADS", max);
+    draw_text_bg(x, y, buf, 0xFFFFFFFF);
+    draw_text_bg(x, y + 16, "DEMO          SPEEDUP  EFF SERIAL", 0xFFC2C3C7);
+
+    for (int d = 0; d < DEMO_COUNT; d++)
+    {
+        double sp = speedup(d, step_count - 1), f = serial_fraction(d);
+        if (f >= 0)
+            snprintf(serial, sizeof(serial), "%5.1f%%", f * 100.0);
+        else
+            snprintf(serial, sizeof(serial), "%6s", "-");
+        snprintf(buf, sizeof(buf), "%-13s %6.2fX %3.0f%% %s", demos[d].name, sp, sp * 100.0 / max, serial);
+        draw_text_bg(x, y + 24 + d * 8, buf, colors[d]);
+    }
+
+    if (max > 1)
+        draw_chart();
+    else
+        draw_text_bg(CHART_X, CHART_Y, "ONE THREAD: NOTHING TO SCALE", 0xFFC2C3C7);
+}
@@ -0,0 +1,271 @@
+#include "pibench.h"
+#include "simd.h"
+
+#define SIZE_COUNT 4
+#define MAX_SIZE 512
+#define NAIVE_MAX_SIZE 256 // Larger naive runs stall the display for seconds on a Pi 3
+#define BLOCK 64
+#define ROWS_PER_JOB 32
+#define KERNEL_COUNT 3
+#define VARIANT_COUNT (KERNEL_COUNT * 2)
+
+static const int sizes[SIZE_COUNT] = {64, 128, 256, 512};
+static const char *kernel_names[KERNEL_COUNT] = {"NAIVE", "BLOCKED", NULL};
+
+// The SIMD kernel is named after the level SIMD_CALL dispatches to
+static const char *kernel_name(int kernel)
+{
+    return kernel == 2 ? simd_level_name() : kernel_names[kernel];
+}
+
+// C = A * B with square row-major n x n matrices, n a multiple of 8
+typedef struct {
+    int n;
+    const float *a;
+    const float *b;
+    float *b_packed; // B in panels of 8 columns, each panel k-major
+    float *c;
+    int kernel;
+} gemm_t;
+
+static float *mat_a, *mat_b, *mat_b_packed, *mat_c;
+
+// Per variant and size: floating-point operations done and time spent
+static double flops[VARIANT_COUNT][SIZE_COUNT];
+static uint64_t usecs[VARIANT_COUNT][SIZE_COUNT];
+static float last_time = 0;
+static int frame_counter = 0;
+
+static void gemm_naive(const gemm_t *g, int i0, int i1)
+{
+    const int n = g->n;
+    for (int i = i0; i < i1; i++)
+    {
+        for (int j = 0; j < n; j++)
+        {
+            float sum = 0.0f;
+            for (int k = 0; k < n; k++)
+                sum += g->a[i * n + k] * g->b[k * n + j];
+            g->c[i * n + j] = sum;
+        }
+    }
+}
+
+// Loop tiling keeps a BLOCK x BLOCK tile of B hot while rows of C stream by
+static void gemm_blocked(const gemm_t *g, int i0, int i1)
+{
+    const int n = g->n;
+    memset(g->c + i0 * n, 0, (size_t)(i1 - i0) * n * sizeof(float));
+
+    for (int ii = i0; ii < i1; ii += BLOCK)
+    {
+        int imax = MIN(ii + BLOCK, i1);
+        for (int kk = 0; kk < n; kk += BLOCK)
+        {
+            int kmax = MIN(kk + BLOCK, n);
+            for (int jj = 0; jj < n; jj += BLOCK)
+            {
+                int jmax = MIN(jj + BLOCK, n);
+                for (int i = ii; i < imax; i++)
+                {
+                    float *c = g->c + i * n;
+                    for (int k = kk; k < kmax; k++)
+                    {
+                        float a = g->a[i * n + k];
+                        const float *b = g->b + k * n;
+                        for (int j = jj; j < jmax; j++)
+                            c[j] += a * b[j];
+                    }
+                }
+            }
+        }
+    }
+}
+
+static void pack_b(const gemm_t *g)
+{
+    const int n = g->n;
+    for (int j = 0; j < n; j += 8)
+    {
+        float *panel = g->b_packed + j * n;
+        for (int k = 0; k < n; k++)
+            memcpy(panel + k * 8, g->b + k * n + j, 8 * sizeof(float));
+    }
+}
+
+// 4x8 register-blocked micro-kernel: eight vector accumulators, one
+// broadcast of A per row and two panel loads of B per k step. On x86 the
+// fast clone fuses each multiply-add with FMA.
+SIMD_KERNEL void gemm_simd_body(const gemm_t *g, int i0, int i1)
+{
+    const int n = g->n;
+
+    for (int j = 0; j < n; j += 8)
+    {
+        const float *panel = g->b_packed + j * n;
+        for (int i = i0; i < i1; i += 4)
+        {
+            const float *a0 = g->a + i * n;
+            const float *a1 = a0 + n, *a2 = a1 + n, *a3 = a2 + n;
+            v4f c00 = v4f_set1(0.0f), c01 = c00, c10 = c00, c11 = c00;
+            v4f c20 = c00, c21 = c00, c30 = c00, c31 = c00;
+
+            for (int k = 0; k < n; k++)
+            {
+                v4f b0 = v4f_load(panel + k * 8);
+                v4f b1 = v4f_load(panel + k * 8 + 4);
+                v4f a;
+                a = v4f_set1(a0[k]);
+                c00 = v4f_madd(a, b0, c00);
+                c01 = v4f_madd(a, b1, c01);
+                a = v4f_set1(a1[k]);
+                c10 = v4f_madd(a, b0, c10);
+                c11 = v4f_madd(a, b1, c11);
+                a = v4f_set1(a2[k]);
+                c20 = v4f_madd(a, b0, c20);
+                c21 = v4f_madd(a, b1, c21);
+                a = v4f_set1(a3[k]);
+                c30 = v4f_madd(a, b0, c30);
+                c31 = v4f_madd(a, b1, c31);
+            }
+
+            float *c = g->c + i * n + j;
+            v4f_store(c, c00);
+            v4f_store(c + 4, c01);
+            v4f_store(c + n, c10);
+            v4f_store(c + n + 4, c11);
+            v4f_store(c + 2 * n, c20);
+            v4f_store(c + 2 * n + 4, c21);
+            v4f_store(c + 3 * n, c30);
+            v4f_store(c + 3 * n + 4, c31);
+        }
+    }
+}
+
+SIMD_CLONES(gemm_simd, (const gemm_t *g, int i0, int i1), (g, i0, i1))
+
+static void gemm_simd(const gemm_t *g, int i0, int i1)
+{
+    SIMD_CALL(gemm_simd, (g, i0, i1));
+}
+
+static void gemm_job(int index, void *arg)
+{
+    const gemm_t *g = (const gemm_t *)arg;
+    int i0 = index * ROWS_PER_JOB;
+    int i1 = MIN(i0 + ROWS_PER_JOB, g->n);
+
+    switch (g->kernel)
+    {
+        case 0: gemm_naive(g, i0, i1); break;
+        case 1: gemm_blocked(g, i0, i1); break;
+        default: gemm_simd(g, i0, i1); break;
+    }
+}
+
+static bool init_matrices(void)
+{
+    if (mat_a)
+        return true;
+
+    size_t bytes = MAX_SIZE * MAX_SIZE * sizeof(float);
+    mat_a = (float *)aligned_alloc(64, bytes);
+    mat_b = (float *)aligned_alloc(64, bytes);
+    mat_b_packed = (float *)aligned_alloc(64, bytes);
+    mat_c = (float *)aligned_alloc(64, bytes);
+    if (!mat_a || !mat_b || !mat_b_packed || !mat_c)
+    {
+        // Retry next frame from scratch rather than with a partial set
+        free(mat_a);
+        free(mat_b);
+        free(mat_b_packed);
+        free(mat_c);
+        mat_a = mat_b = mat_b_packed = mat_c = NULL;
+        return false;
+    }
+
+    uint32_t seed = 12345;
+    for (int i = 0; i < MAX_SIZE * MAX_SIZE; i++)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        mat_a[i] = (seed >> 8) * (1.0f / 16777216.0f) - 0.5f;
+        seed = seed * 1664525u + 1013904223u;
+        mat_b[i] = (seed >> 8) * (1.0f / 16777216.0f) - 0.5f;
+    }
+    return true;
+}
+
+static void draw_table(int threads)
+{
+    char buf[64];
+    int x = 32, y = 176;
+
+    int len = snprintf(buf, sizeof(buf), "%-19s", "SGEMM GFLOPS");
+    for (int s = 0; s < SIZE_COUNT; s++)
+        len += snprintf(buf + len, sizeof(buf) - len, " %6d", sizes[s]);
+    draw_text_bg(x, y, buf, 0xFFFFFFFF);
+
+    for (int v = 0; v < VARIANT_COUNT; v++)
+    {
+        len = snprintf(buf, sizeof(buf), "%-8s %2d THREAD%s", kernel_name(v % KERNEL_COUNT),
+                           v < KERNEL_COUNT ? 1 : threads,
+                           v >= KERNEL_COUNT && threads > 1 ? "S" : " ");
+        for (int s = 0; s < SIZE_COUNT; s++)
+        {
+            if (usecs[v][s])
+                len += snprintf(buf + len, sizeof(buf) - len, " %6.2f", flops[v][s] / usecs[v][s] / 1000.0);
+            else
+                len += snprintf(buf + len, sizeof(buf) - len, "      -");
+        }
+        draw_text_bg(x, y + 16 + v * 8, buf, 0xFFFFFFFF);
+    }
+}
+
+// Single-precision matrix multiply at several sizes. The demo time is split
+// between naive, cache-blocked and SIMD micro-kernel GEMMs, each run on one
+// thread and then across the worker pool.
+void render_sgemm(float time)
+{
+    char label[40];
+    int threads = thread_count();
+    int variant = demo_variant(time, VARIANT_COUNT);
+    int kernel = variant % KERNEL_COUNT;
+    bool parallel = variant >= KERNEL_COUNT;
+
+    if (time < last_time)
+    {
+        memset(flops, 0, sizeof(flops));
+        memset(usecs, 0, sizeof(usecs));
+    }
+    last_time = time;
+
+    if (!init_matrices())
+    {
+        draw_text_bg(32, 176, "SGEMM: OUT OF MEMORY", 0xFFFFFFFF);
+        return;
+    }
+
+    // One size per frame keeps every frame short enough to stay responsive
+    int s = frame_counter++ % SIZE_COUNT;
+    if (kernel == 0 && sizes[s] > NAIVE_MAX_SIZE)
+        s = frame_counter++ % SIZE_COUNT;
+
+    gemm_t g = {sizes[s], mat_a, mat_b, mat_b_packed, mat_c, kernel};
+    int jobs = (g.n + ROWS_PER_JOB - 1) / ROWS_PER_JOB;
+
+    uint64_t t0 = get_time_usec();
+    if (kernel == 2)
+        pack_b(&g);
+    run_parallel(parallel ? threads : 1, jobs, gemm_job, &g);
+    uint64_t t1 = get_time_usec();
+
+    double ops = 2.0 * g.n * g.n * g.n;
+    flops[variant][s] += ops;
+    usecs[variant][s] += t1 - t0;
+
+    snprintf(label, sizeof(label), "FLOPS (%s, %d THREAD%s)", kernel_name(kernel),
+             parallel ? threads : 1, parallel && threads > 1 ? "S" : "");
+    add_demo_stat(variant, label, ops, t1 - t0);
+
+    draw_table(threads);
+}
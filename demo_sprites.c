@@ -0,0 +1,235 @@
+#include "pibench.h"
+#include "simd.h"
+
+#define SPRITES_PER_STRESS 2048
+#define SPRITE_IMAGES 8
+#define ROWS_PER_JOB 16
+
+typedef struct {
+    int w, h;
+    uint32_t *pixels; // Pixels equal to 0 are transparent
+} sprite_image_t;
+
+typedef struct {
+    float x, y, vx, vy;
+    int image;
+    int px, py; // Top-left corner this frame
+} sprite_t;
+
+typedef struct {
+    const sprite_t *sprites;
+    int count;
+    bool simd;
+} sprite_job_t;
+
+static sprite_image_t images[SPRITE_IMAGES];
+static bool images_ready = false;
+
+static const uint32_t palette[SPRITE_IMAGES] = {
+    0xFFFF004D, 0xFFFFA300, 0xFFFFEC27, 0xFF00E436,
+    0xFF29ADFF, 0xFF83769C, 0xFFFF77A8, 0xFFFFCCAA
+};
+
+// Shaded ball, ring, diamond and cross at 12, 16, 24 and 32 pixels, so
+// most widths leave a scalar tail after the 4-pixel SIMD groups
+static bool build_images(void)
+{
+    static const int sizes[4] = {12, 16, 24, 32};
+
+    for (int i = 0; i < SPRITE_IMAGES; i++)
+    {
+        sprite_image_t *img = &images[i];
+        int size = sizes[i & 3], shape = (i + (i >> 2)) & 3;
+        float r = size * 0.5f;
+        img->w = img->h = size;
+        img->pixels = (uint32_t *)malloc(size * size * sizeof(uint32_t));
+        if (!img->pixels)
+        {
+            for (int j = 0; j < i; j++)
+            {
+                free(images[j].pixels);
+                images[j].pixels = NULL;
+            }
+            return false;
+        }
+
+        for (int y = 0; y < size; y++)
+        {
+            for (int x = 0; x < size; x++)
+            {
+                float dx = x + 0.5f - r, dy = y + 0.5f - r;
+                float d = sqrtf(dx * dx + dy * dy) / r;
+                bool solid;
+                switch (shape)
+                {
+                    case 0: solid = d < 1.0f; break;
+                    case 1: solid = d < 1.0f && d > 0.55f; break;
+                    case 2: solid = fabsf(dx) + fabsf(dy) < r; break;
+                    default: solid = fabsf(dx) < r * 0.3f || fabsf(dy) < r * 0.3f; break;
+                }
+
+                // Light from the top left, keeping every channel non-zero
+                float light = 1.0f - 0.45f * MIN(MAX((dx + dy) / (2.0f * r) + 0.5f, 0.0f), 1.0f);
+                uint32_t c = palette[i];
+                int red = (int)(((c >> 16) & 0xFF) * light) | 1;
+                int green = (int)(((c >> 8) & 0xFF) * light) | 1;
+                int blue = (int)((c & 0xFF) * light) | 1;
+                img->pixels[y * size + x] = solid ? 0xFF000000 | (red << 16) | (green << 8) | blue : 0;
+            }
+        }
+    }
+    images_ready = true;
+    return true;
+}
+
+static void key_span(uint32_t *dst, const uint32_t *src, int len)
+{
+    for (int i = 0; i < len; i++)
+    {
+        if (src[i])
+            dst[i] = src[i];
+    }
+}
+
+// Masked store of 4 pixels at a time: keep the destination where the
+// source matches the colour key
+SIMD_KERNEL void key_span_simd_body(uint32_t *dst, const uint32_t *src, int len)
+{
+    const v4i zero = v4i_set1(0);
+    int i = 0;
+    for (; i + 4 <= len; i += 4)
+    {
+        v4i s = v4i_load((const int32_t *)src + i);
+        v4i d = v4i_load((const int32_t *)dst + i);
+        v4i_store((int32_t *)dst + i, v4i_select(v4i_cmpeq(s, zero), d, s));
+    }
+    key_span(dst + i, src + i, len - i);
+}
+
+SIMD_CLONES(key_span_simd, (uint32_t *dst, const uint32_t *src, int len), (dst, src, len))
+
+// Position wrapped so sprites slide fully off one edge and back in at the other
+static int wrap_position(float p, int size, int extent)
+{
+    float span = (float)(extent + size);
+    p = fmodf(p, span);
+    if (p < 0)
+        p += span;
+    return (int)p - size;
+}
+
+static void move_sprites(sprite_t *sprites, int count, float time)
+{
+    for (int i = 0; i < count; i++)
+    {
+        sprite_t *s = &sprites[i];
+        s->px = wrap_position(s->x + s->vx * time, images[s->image].w, VIDEO_WIDTH);
+        s->py = wrap_position(s->y + s->vy * time, images[s->image].h, VIDEO_HEIGHT);
+    }
+}
+
+// Draw every sprite clipped to the screen and to rows [clip_y0, clip_y1)
+static void draw_sprites(const sprite_job_t *job, int clip_y0, int clip_y1)
+{
+    uint32_t *pixels = (uint32_t *)frame_buf;
+
+    for (int i = 0; i < job->count; i++)
+    {
+        const sprite_t *s = &job->sprites[i];
+        const sprite_image_t *img = &images[s->image];
+        int x = s->px, y = s->py;
+
+        int x0 = MAX(x, 0), x1 = MIN(x + img->w, VIDEO_WIDTH);
+        int y0 = MAX(y, clip_y0), y1 = MIN(y + img->h, clip_y1);
+        if (x0 >= x1 || y0 >= y1)
+            continue;
+
+        for (int py = y0; py < y1; py++)
+        {
+            uint32_t *dst = pixels + py * VIDEO_WIDTH + x0;
+            const uint32_t *src = img->pixels + (py - y) * img->w + (x0 - x);
+            if (job->simd)
+                SIMD_CALL(key_span_simd, (dst, src, x1 - x0));
+            else
+                key_span(dst, src, x1 - x0);
+        }
+    }
+}
+
+static void sprite_job(int index, void *arg)
+{
+    int y0 = index * ROWS_PER_JOB;
+    draw_sprites((const sprite_job_t *)arg, y0, MIN(y0 + ROWS_PER_JOB, VIDEO_HEIGHT));
+}
+
+// Colour-keyed sprite blitter: thousands of sprites drifting across the
+// screen and clipped at its edges, with SPRITES_PER_STRESS more per stress
+// level. The demo time is split between a scalar per-pixel key test, a
+// SIMD masked store and the SIMD path across the pool in row bands. Besides
+// sprites/s, each path reports how many sprites fit in a 60 FPS frame.
+void render_sprites(float time)
+{
+    static sprite_t *sprites = NULL;
+    static int sprites_capacity = 0;
+    int threads = thread_count();
+    int variant = demo_variant(time, 3);
+    int count = SPRITES_PER_STRESS * options.stress;
+
+    if (!images_ready && !build_images())
+    {
+        draw_text_bg(32, 144, "SPRITES: OUT OF MEMORY", 0xFFFFFFFF);
+        return;
+    }
+
+    if (sprites_capacity < count)
+    {
+        sprite_t *grown = (sprite_t *)realloc(sprites, count * sizeof(sprite_t));
+        if (!grown)
+        {
+            draw_text_bg(32, 144, "SPRITES: OUT OF MEMORY", 0xFFFFFFFF);
+            return;
+        }
+        sprites = grown;
+        for (int i = sprites_capacity; i < count; i++)
+        {
+            uint32_t h = hash32(i * 4 + 1), g = hash32(i * 4 + 2);
+            float angle = (h & 0xFFFF) * (2.0f * M_PI / 65536.0f);
+            float speed = 20.0f + (g & 0xFF) * 0.5f;
+            sprites[i].x = (float)((h >> 16) % (VIDEO_WIDTH + 32));
+            sprites[i].y = (float)((g >> 8) % (VIDEO_HEIGHT + 32));
+            sprites[i].vx = cosf(angle) * speed;
+            sprites[i].vy = sinf(angle) * speed;
+            sprites[i].image = (g >> 24) % SPRITE_IMAGES;
+        }
+        sprites_capacity = count;
+    }
+
+    // Movement is untimed so every path measures the blit alone
+    move_sprites(sprites, count, time);
+    sprite_job_t job = {sprites, count, variant > 0};
+
+    uint64_t t0 = get_time_usec();
+    if (variant == 2)
+        run_parallel(threads, (VIDEO_HEIGHT + ROWS_PER_JOB - 1) / ROWS_PER_JOB, sprite_job, &job);
+    else
+        draw_sprites(&job, 0, VIDEO_HEIGHT);
+    uint64_t t1 = get_time_usec();
+
+    char path[24], label[64];
+    switch (variant)
+    {
+        case 0:
+            snprintf(path, sizeof(path), "SCALAR");
+            break;
+        case 1:
+            snprintf(path, sizeof(path), "%s", simd_level_name());
+            break;
+        default:
+            snprintf(path, sizeof(path), "%s, %d THREAD%s", simd_level_name(), threads, threads > 1 ? "S" : "");
+            break;
+    }
+    snprintf(label, sizeof(label), "SPRITES/S (%s)", path);
+    add_demo_stat(variant, label, count, t1 - t0);
+    snprintf(label, sizeof(label), "SPRITES/60FPS FRAME (%s)", path);
+    add_demo_stat(3 + variant, label, count / 60.0, t1 - t0);
+}
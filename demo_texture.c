@@ -0,0 +1,408 @@
+#include "pibench.h"
+#include "simd.h"
+
+#define SIZE_COUNT 4
+#define VARIANT_COUNT 7
+#define MAX_LEVELS 12
+#define ROWS_PER_JOB 16
+
+// ARGB8888 level-0 footprints of 16 KB, 256 KB, 4 MB and 16 MB
+static const int size_log2[SIZE_COUNT] = {6, 8, 10, 11};
+static const char *size_names[SIZE_COUNT] = {"16KB", "256KB", "4MB", "16MB"};
+
+typedef enum {
+    FILTER_NEAREST,
+    FILTER_BILINEAR,
+    FILTER_TRILINEAR
+} filter_t;
+
+static const char *filter_names[] = {"NEAREST", "BILINEAR", "TRILINEAR"};
+
+typedef struct {
+    int log2;
+    int levels;
+    uint32_t *level[MAX_LEVELS];
+} texture_t;
+
+// Texture coordinates in 16.16 texels of one mip level, stepped per pixel
+typedef struct {
+    int log2;
+    const uint32_t *texels;
+    uint32_t u0, v0;
+    uint32_t dudx, dvdx, dudy, dvdy;
+} level_map_t;
+
+typedef struct {
+    filter_t filter;
+    bool simd;
+    uint32_t frac; // Blend towards the coarser level, 0..256
+    level_map_t map[2];
+} sampler_t;
+
+static texture_t textures[SIZE_COUNT];
+
+static double pixels_done[VARIANT_COUNT][SIZE_COUNT];
+static uint64_t usecs[VARIANT_COUNT][SIZE_COUNT];
+static float last_time = 0;
+static int frame_counter = 0;
+
+// 8x8 coloured cells with a ring, a checker shade and dark grid lines,
+// defined on the unit square so every texture size shows the same pattern
+static uint32_t pattern(float u, float v)
+{
+    static const uint32_t pal[] = {
+        0xFFFF004D, 0xFFFFA300, 0xFFFFEC27, 0xFF00E436,
+        0xFF29ADFF, 0xFF83769C, 0xFFFF77A8, 0xFFFFCCAA
+    };
+    int cx = (int)(u * 8.0f), cy = (int)(v * 8.0f);
+    float lx = u * 8.0f - cx - 0.5f, ly = v * 8.0f - cy - 0.5f;
+    float d = sqrtf(lx * lx + ly * ly);
+
+    if (fabsf(lx) > 0.47f || fabsf(ly) > 0.47f)
+        return 0xFF1D2B53;
+    if (fabsf(d - 0.3f) < 0.05f)
+        return 0xFFFFF1E8;
+
+    uint32_t c = pal[(cx + cy * 3) & 7];
+    if ((cx + cy) & 1)
+        c = 0xFF000000 | ((c >> 1) & 0x007F7F7F);
+    return c;
+}
+
+static uint32_t average4(uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+{
+    uint32_t r = 0;
+    for (int s = 0; s < 32; s += 8)
+    {
+        uint32_t sum = ((a >> s) & 0xFF) + ((b >> s) & 0xFF) + ((c >> s) & 0xFF) + ((d >> s) & 0xFF);
+        r |= ((sum + 2) >> 2) << s;
+    }
+    return r;
+}
+
+static bool build_texture(texture_t *tex, int log2)
+{
+    if (tex->levels)
+        return true;
+
+    int size = 1 << log2;
+    for (int l = 0; l <= log2; l++)
+    {
+        int ls = size >> l;
+        tex->level[l] = (uint32_t *)malloc((size_t)ls * ls * sizeof(uint32_t));
+        if (!tex->level[l])
+            return false;
+    }
+
+    for (int y = 0; y < size; y++)
+        for (int x = 0; x < size; x++)
+            tex->level[0][y * size + x] = pattern((x + 0.5f) / size, (y + 0.5f) / size);
+
+    // Box-filtered mip chain down to 1x1
+    for (int l = 1; l <= log2; l++)
+    {
+        int ls = size >> l;
+        const uint32_t *src = tex->level[l - 1];
+        for (int y = 0; y < ls; y++)
+        {
+            for (int x = 0; x < ls; x++)
+            {
+                const uint32_t *p = src + (2 * y) * (2 * ls) + 2 * x;
+                tex->level[l][y * ls + x] = average4(p[0], p[1], p[2 * ls], p[2 * ls + 1]);
+            }
+        }
+    }
+
+    tex->log2 = log2;
+    tex->levels = log2 + 1;
+    return true;
+}
+
+// Per-channel a + (b - a) * f / 256 on packed ARGB, two channels per multiply
+static inline uint32_t lerp_argb(uint32_t a, uint32_t b, uint32_t f)
+{
+    uint32_t rb = (((a & 0x00FF00FF) * (256 - f) + (b & 0x00FF00FF) * f) >> 8) & 0x00FF00FF;
+    uint32_t ag = (((a >> 8) & 0x00FF00FF) * (256 - f) + ((b >> 8) & 0x00FF00FF) * f) & 0xFF00FF00;
+    return rb | ag;
+}
+
+static inline uint32_t sample_nearest(const level_map_t *m, uint32_t u, uint32_t v)
+{
+    uint32_t mask = (1u << m->log2) - 1;
+    return m->texels[(((v >> 16) & mask) << m->log2) | ((u >> 16) & mask)];
+}
+
+static inline uint32_t sample_bilinear(const level_map_t *m, uint32_t u, uint32_t v)
+{
+    uint32_t mask = (1u << m->log2) - 1;
+    u -= 0x8000; // Texel centres sit at +0.5
+    v -= 0x8000;
+    uint32_t x0 = (u >> 16) & mask, x1 = (x0 + 1) & mask;
+    uint32_t y0 = (v >> 16) & mask, y1 = (y0 + 1) & mask;
+    uint32_t fx = (u >> 8) & 0xFF, fy = (v >> 8) & 0xFF;
+    const uint32_t *r0 = m->texels + (y0 << m->log2);
+    const uint32_t *r1 = m->texels + (y1 << m->log2);
+
+    return lerp_argb(lerp_argb(r0[x0], r0[x1], fx), lerp_argb(r1[x0], r1[x1], fx), fy);
+}
+
+static void render_rows_scalar(const sampler_t *s, int y0, int y1)
+{
+    uint32_t *pixels = (uint32_t *)frame_buf;
+    const level_map_t *m0 = &s->map[0], *m1 = &s->map[1];
+
+    for (int y = y0; y < y1; y++)
+    {
+        uint32_t u = m0->u0 + y * m0->dudy, v = m0->v0 + y * m0->dvdy;
+        uint32_t u1 = m1->u0 + y * m1->dudy, v1 = m1->v0 + y * m1->dvdy;
+        uint32_t *row = pixels + y * VIDEO_WIDTH;
+
+        for (int x = 0; x < VIDEO_WIDTH; x++)
+        {
+            switch (s->filter)
+            {
+                case FILTER_NEAREST:
+                    row[x] = sample_nearest(m0, u, v);
+                    break;
+                case FILTER_BILINEAR:
+                    row[x] = sample_bilinear(m0, u, v);
+                    break;
+                default:
+                    row[x] = lerp_argb(sample_bilinear(m0, u, v), sample_bilinear(m1, u1, v1), s->frac);
+                    break;
+            }
+            u += m0->dudx;
+            v += m0->dvdx;
+            u1 += m1->dudx;
+            v1 += m1->dvdx;
+        }
+    }
+}
+
+static inline v4i lerp_argb4(v4i a, v4i b, v4i f)
+{
+    const v4i mask = v4i_set1(0x00FF00FF);
+    v4i g = v4i_sub(v4i_set1(0x01000100), f);
+    v4i rb = v4i_add(v4i_mul16(v4i_and(a, mask), g), v4i_mul16(v4i_and(b, mask), f));
+    v4i ag = v4i_add(v4i_mul16(v4i_and(v4i_shr(a, 8), mask), g), v4i_mul16(v4i_and(v4i_shr(b, 8), mask), f));
+    return v4i_or(v4i_and(v4i_shr(rb, 8), mask), v4i_and(ag, v4i_set1((int32_t)0xFF00FF00)));
+}
+
+// Fraction 0..255 copied into both 16-bit halves for v4i_mul16
+static inline v4i weight4(v4i coord)
+{
+    v4i f = v4i_and(v4i_shr(coord, 8), v4i_set1(0xFF));
+    return v4i_or(f, v4i_shl(f, 16));
+}
+
+// Coordinates are computed four lanes at a time; texel fetches are scalar
+// gathers, as neither NEON nor SSE2 can load from four addresses at once
+static inline v4i gather4(const uint32_t *texels, v4i index)
+{
+    int32_t idx[4], t[4];
+    v4i_store(idx, index);
+    for (int i = 0; i < 4; i++)
+        t[i] = (int32_t)texels[idx[i]];
+    return v4i_load(t);
+}
+
+static inline v4i sample_nearest4(const level_map_t *m, v4i u, v4i v)
+{
+    v4i mask = v4i_set1((1 << m->log2) - 1);
+    v4i x = v4i_and(v4i_shr(u, 16), mask);
+    v4i y = v4i_and(v4i_shr(v, 16), mask);
+    return gather4(m->texels, v4i_add(v4i_mul(y, v4i_set1(1 << m->log2)), x));
+}
+
+static inline v4i sample_bilinear4(const level_map_t *m, v4i u, v4i v)
+{
+    v4i mask = v4i_set1((1 << m->log2) - 1);
+    v4i stride = v4i_set1(1 << m->log2);
+    v4i one = v4i_set1(1);
+    u = v4i_sub(u, v4i_set1(0x8000));
+    v = v4i_sub(v, v4i_set1(0x8000));
+    v4i x0 = v4i_and(v4i_shr(u, 16), mask), x1 = v4i_and(v4i_add(x0, one), mask);
+    v4i y0 = v4i_and(v4i_shr(v, 16), mask), y1 = v4i_and(v4i_add(y0, one), mask);
+    v4i r0 = v4i_mul(y0, stride), r1 = v4i_mul(y1, stride);
+    v4i fx = weight4(u), fy = weight4(v);
+
+    v4i top = lerp_argb4(gather4(m->texels, v4i_add(r0, x0)), gather4(m->texels, v4i_add(r0, x1)), fx);
+    v4i bottom = lerp_argb4(gather4(m->texels, v4i_add(r1, x0)), gather4(m->texels, v4i_add(r1, x1)), fx);
+    return lerp_argb4(top, bottom, fy);
+}
+
+static inline v4i lanes4(uint32_t start, uint32_t step)
+{
+    int32_t t[4];
+    for (int i = 0; i < 4; i++)
+        t[i] = (int32_t)(start + i * step);
+    return v4i_load(t);
+}
+
+static void render_rows_simd(const sampler_t *s, int y0, int y1)
+{
+    int32_t *pixels = (int32_t *)frame_buf;
+    const level_map_t *m0 = &s->map[0], *m1 = &s->map[1];
+    v4i du = v4i_set1((int32_t)(m0->dudx * 4)), dv = v4i_set1((int32_t)(m0->dvdx * 4));
+    v4i du1 = v4i_set1((int32_t)(m1->dudx * 4)), dv1 = v4i_set1((int32_t)(m1->dvdx * 4));
+    v4i frac = v4i_set1((int32_t)(s->frac | s->frac << 16));
+
+    for (int y = y0; y < y1; y++)
+    {
+        v4i u = lanes4(m0->u0 + y * m0->dudy, m0->dudx), v = lanes4(m0->v0 + y * m0->dvdy, m0->dvdx);
+        v4i u1 = lanes4(m1->u0 + y * m1->dudy, m1->dudx), v1 = lanes4(m1->v0 + y * m1->dvdy, m1->dvdx);
+        int32_t *row = pixels + y * VIDEO_WIDTH;
+
+        for (int x = 0; x < VIDEO_WIDTH; x += 4)
+        {
+            v4i c;
+            switch (s->filter)
+            {
+                case FILTER_NEAREST:
+                    c = sample_nearest4(m0, u, v);
+                    break;
+                case FILTER_BILINEAR:
+                    c = sample_bilinear4(m0, u, v);
+                    break;
+                default:
+                    c = lerp_argb4(sample_bilinear4(m0, u, v), sample_bilinear4(m1, u1, v1), frac);
+                    break;
+            }
+            v4i_store(row + x, c);
+            u = v4i_add(u, du);
+            v = v4i_add(v, dv);
+            u1 = v4i_add(u1, du1);
+            v1 = v4i_add(v1, dv1);
+        }
+    }
+}
+
+static void render_job(int index, void *arg)
+{
+    int y0 = index * ROWS_PER_JOB;
+    render_rows_simd((const sampler_t *)arg, y0, MIN(y0 + ROWS_PER_JOB, VIDEO_HEIGHT));
+}
+
+static inline uint32_t to_fixed(double texels)
+{
+    return (uint32_t)(int64_t)llrint(texels * 65536.0);
+}
+
+// Rotozoom mapping for one mip level: screen pixel centres to texel space
+static void map_level(level_map_t *m, const texture_t *tex, int level, double cx, double cy,
+                      double scale, double angle)
+{
+    double k = 1.0 / (1 << level);
+    double c = cos(angle) * scale * k, s = sin(angle) * scale * k;
+    double x0 = 0.5 - VIDEO_WIDTH / 2, y0 = 0.5 - VIDEO_HEIGHT / 2;
+
+    m->log2 = tex->log2 - level;
+    m->texels = tex->level[level];
+    m->u0 = to_fixed(cx * k + x0 * c - y0 * s);
+    m->v0 = to_fixed(cy * k + x0 * s + y0 * c);
+    m->dudx = to_fixed(c);
+    m->dvdx = to_fixed(s);
+    m->dudy = to_fixed(-s);
+    m->dvdy = to_fixed(c);
+}
+
+static void draw_table(const char names[][40])
+{
+    char buf[80], rate[16];
+    int x = 32, y = 160;
+
+    int len = snprintf(buf, sizeof(buf), "%-28s", "PIXELS/S");
+    for (int s = 0; s < SIZE_COUNT; s++)
+        len += snprintf(buf + len, sizeof(buf) - len, " %7s", size_names[s]);
+    draw_text_bg(x, y, buf, 0xFFFFFFFF);
+
+    for (int v = 0; v < VARIANT_COUNT; v++)
+    {
+        len = snprintf(buf, sizeof(buf), "%-28s", names[v]);
+        for (int s = 0; s < SIZE_COUNT; s++)
+        {
+            if (usecs[v][s])
+                format_si(rate, sizeof(rate), pixels_done[v][s] * 1000000.0 / usecs[v][s]);
+            else
+                snprintf(rate, sizeof(rate), "-");
+            len += snprintf(buf + len, sizeof(buf) - len, " %7s", rate);
+        }
+        draw_text_bg(x, y + 8 + v * 8, buf, 0xFFFFFFFF);
+    }
+}
+
+// Full-screen rotating and zooming texture. The demo time is split between
+// nearest, bilinear and mipmapped trilinear filtering, scalar then SIMD,
+// then trilinear SIMD across the worker pool. Each frame samples one of
+// four texture sizes so the table shows the cost of leaving the caches.
+// Rates count output pixels, which take 1, 4 and 8 texel reads for the
+// three filters, so every variant is measured in the same unit.
+void render_texture(float time)
+{
+    char names[VARIANT_COUNT][40];
+    char label[sizeof("PIXELS/S ()") + sizeof(names[0])];
+    int threads = thread_count();
+    int variant = demo_variant(time, VARIANT_COUNT);
+
+    if (time < last_time)
+    {
+        memset(pixels_done, 0, sizeof(pixels_done));
+        memset(usecs, 0, sizeof(usecs));
+    }
+    last_time = time;
+
+    for (int v = 0; v < VARIANT_COUNT; v++)
+    {
+        if (v < 6)
+            snprintf(names[v], sizeof(names[v]), "%s %s", filter_names[v % 3], v < 3 ? "SCALAR" : SIMD_NAME);
+        else
+            snprintf(names[v], sizeof(names[v]), "TRILINEAR %s, %d THREAD%s", SIMD_NAME, threads,
+                     threads > 1 ? "S" : "");
+    }
+
+    int s = frame_counter++ % SIZE_COUNT;
+    texture_t *tex = &textures[s];
+    if (!build_texture(tex, size_log2[s]))
+    {
+        draw_text_bg(32, 160, "TEXTURE: OUT OF MEMORY", 0xFFFFFFFF);
+        return;
+    }
+
+    // About one texture width across the screen, zooming in and out by 2x
+    int size = 1 << tex->log2;
+    double scale = (double)size / VIDEO_WIDTH * pow(2.0, sin(time * 0.5));
+    double angle = time * 0.3;
+    double cx = size * (0.5 + 0.25 * sin(time * 0.13));
+    double cy = size * (0.5 + 0.25 * cos(time * 0.11));
+
+    // The rotozoom has the same footprint everywhere, so one LOD per frame
+    double lod = log2(scale);
+    int level = MIN(MAX((int)floor(lod), 0), tex->levels - 2);
+    double frac = fmin(fmax(lod - level, 0.0), 1.0);
+
+    sampler_t sampler;
+    sampler.filter = (filter_t)(variant % 3);
+    sampler.simd = variant >= 3;
+    sampler.frac = (uint32_t)lrint(frac * 256.0);
+    if (variant == 6)
+        sampler.filter = FILTER_TRILINEAR;
+    map_level(&sampler.map[0], tex, sampler.filter == FILTER_TRILINEAR ? level : 0, cx, cy, scale, angle);
+    map_level(&sampler.map[1], tex, level + 1, cx, cy, scale, angle);
+
+    uint64_t t0 = get_time_usec();
+    if (variant == 6)
+        run_parallel(threads, (VIDEO_HEIGHT + ROWS_PER_JOB - 1) / ROWS_PER_JOB, render_job, &sampler);
+    else if (sampler.simd)
+        render_rows_simd(&sampler, 0, VIDEO_HEIGHT);
+    else
+        render_rows_scalar(&sampler, 0, VIDEO_HEIGHT);
+    uint64_t t1 = get_time_usec();
+
+    pixels_done[variant][s] += VIDEO_PIXELS;
+    usecs[variant][s] += t1 - t0;
+
+    snprintf(label, sizeof(label), "PIXELS/S (%s)", names[variant]);
+    add_demo_stat(variant, label, VIDEO_PIXELS, t1 - t0);
+
+    draw_table(names);
+}
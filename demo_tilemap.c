@@ -0,0 +1,339 @@
+#include "pibench.h"
+#include "simd.h"
+
+#define ROWS_PER_JOB 16
+#define MAX_TILES 16
+#define LAYER_TYPES 4
+
+typedef enum {
+    TILE_EMPTY,
+    TILE_OPAQUE,
+    TILE_MASKED // Pixels equal to 0 are transparent
+} tile_kind_t;
+
+typedef struct {
+    int log2; // 8x8 or 16x16 pixels
+    uint32_t *pixels;
+    uint8_t kind[MAX_TILES];
+} tileset_t;
+
+typedef struct {
+    const tileset_t *set;
+    uint8_t *map;
+    int cols_log2, rows_log2;
+} tilemap_t;
+
+typedef struct {
+    const tilemap_t *map;
+    int scroll_x, scroll_y;
+} layer_t;
+
+typedef struct {
+    const layer_t *layers;
+    int count;
+    bool simd;
+} tile_job_t;
+
+static tileset_t tiles16, tiles8;
+static tilemap_t maps[LAYER_TYPES];
+static bool tiles_ready = false;
+
+static uint32_t rgb(int r, int g, int b)
+{
+    return 0xFF000000 | (MIN(MAX(r, 0), 255) << 16) | (MIN(MAX(g, 0), 255) << 8) | MIN(MAX(b, 0), 255);
+}
+
+// 16x16 set: six sky bands, mountain and hill bodies with masked tops
+static uint32_t tile16_pixel(int id, int x, int y)
+{
+    if (id >= 1 && id <= 6)
+    {
+        float t = ((id - 1) * 16 + y) / 96.0f;
+        bool star = id <= 2 && (hash32(id * 256 + y * 16 + x) & 0x1FF) < 3;
+        return star ? 0xFFFFF1E8 : rgb(20 + (int)(t * 200), 20 + (int)(t * 90), 80 + (int)(t * 40));
+    }
+    switch (id)
+    {
+        case 7: return ((x + y) & 3) ? 0xFF008751 : 0xFF00A060;
+        case 8: return y < 6 + 3 * sinf(x * M_PI / 16) ? 0 : tile16_pixel(7, x, y);
+        case 9: return ((x ^ y) & 4) ? 0xFF5F574F : 0xFF6A6270;
+        case 10: return abs(2 * x - 15) > 2 * y ? 0 : (y < 5 ? 0xFFC2C3C7 : tile16_pixel(9, x, y));
+        default: return 0;
+    }
+}
+
+// 8x8 set: bricks, crenellated bricks, grass, stone and flowers
+static uint32_t tile8_pixel(int id, int x, int y)
+{
+    bool mortar = y == 3 || y == 7 || (y < 4 ? x == 3 : x == 7);
+    switch (id)
+    {
+        case 1: return mortar ? 0xFF5F574F : 0xFFAB5236;
+        case 2: return (y < 3 && (x & 4)) ? 0 : tile8_pixel(1, x, y);
+        case 3: return (y > 2 && ((x * 5 + y) % 3 == 0 || y > 5)) ? 0xFF00E436 : 0;
+        case 4: return (hash32(x * 8 + y) & 3) ? 0xFF83769C : 0xFF5F574F;
+        case 5:
+            if (y > 3 && x == 3)
+                return 0xFF008751;
+            return (y <= 3 && abs(x - 3) + abs(y - 2) <= 2) ? (x == 3 && y == 2 ? 0xFFFFEC27 : 0xFFFF77A8) : 0;
+        default: return 0;
+    }
+}
+
+static bool build_tileset(tileset_t *set, int log2, uint32_t (*pixel)(int, int, int))
+{
+    int size = 1 << log2;
+    set->log2 = log2;
+    set->pixels = (uint32_t *)malloc(MAX_TILES * size * size * sizeof(uint32_t));
+    if (!set->pixels)
+        return false;
+
+    for (int id = 0; id < MAX_TILES; id++)
+    {
+        uint32_t *p = set->pixels + id * size * size;
+        int solid = 0;
+        for (int i = 0; i < size * size; i++)
+        {
+            p[i] = pixel(id, i & (size - 1), i >> log2);
+            solid += p[i] != 0;
+        }
+        set->kind[id] = solid == 0 ? TILE_EMPTY : (solid == size * size ? TILE_OPAQUE : TILE_MASKED);
+    }
+    return true;
+}
+
+static bool build_map(tilemap_t *m, const tileset_t *set, int cols_log2, int rows_log2)
+{
+    m->set = set;
+    m->cols_log2 = cols_log2;
+    m->rows_log2 = rows_log2;
+    m->map = (uint8_t *)calloc(1 << (cols_log2 + rows_log2), 1);
+    return m->map != NULL;
+}
+
+static void free_tiles(void)
+{
+    free(tiles16.pixels);
+    free(tiles8.pixels);
+    tiles16.pixels = tiles8.pixels = NULL;
+    for (int k = 0; k < LAYER_TYPES; k++)
+    {
+        free(maps[k].map);
+        maps[k].map = NULL;
+    }
+}
+
+static bool build_tiles(void)
+{
+    if (!build_tileset(&tiles16, 4, tile16_pixel) || !build_tileset(&tiles8, 3, tile8_pixel))
+    {
+        free_tiles();
+        return false;
+    }
+    for (int k = 0; k < LAYER_TYPES; k++)
+    {
+        if (!build_map(&maps[k], k < 3 ? &tiles16 : &tiles8, k < 3 ? 6 : 7, k < 3 ? 5 : 6))
+        {
+            free_tiles();
+            return false;
+        }
+    }
+
+    // Sky: opaque bands, 64x32 tiles
+    tilemap_t *m = &maps[0];
+    for (int r = 0; r < 32; r++)
+        for (int c = 0; c < 64; c++)
+            m->map[r * 64 + c] = 1 + MIN(r * 6 / 30, 5);
+
+    // Mountains and hills: a surface row of masked tops over solid bodies
+    for (int k = 1; k <= 2; k++)
+    {
+        m = &maps[k];
+        for (int c = 0; c < 64; c++)
+        {
+            float a = c * 2.0f * M_PI / 64;
+            int h = k == 1 ? 14 + (int)(4 * sinf(a * 3) + 2 * sinf(a * 7))
+                           : 22 + (int)(3 * sinf(a * 4) + sinf(a * 9));
+            for (int r = h; r < 32; r++)
+                m->map[r * 64 + c] = r == h ? (k == 1 ? 10 : 8) : (k == 1 ? 9 : 7);
+        }
+    }
+
+    // Foreground: 128x64 tiles of ground, grass and floating brick platforms
+    m = &maps[3];
+    for (int c = 0; c < 128; c++)
+    {
+        for (int r = 56; r < 64; r++)
+            m->map[r * 128 + c] = 4;
+        if (hash32(c) & 1)
+            m->map[55 * 128 + c] = 3;
+    }
+    for (int p = 0; p < 24; p++)
+    {
+        uint32_t h = hash32(p + 1000);
+        int row = 24 + h % 28, col = (h >> 8) % 128, len = 4 + (h >> 16) % 9;
+        for (int i = 0; i < len; i++)
+        {
+            int c = (col + i) & 127;
+            m->map[row * 128 + c] = 1;
+            m->map[(row - 1) * 128 + c] = (hash32(p * 64 + i) & 3) ? 2 : 5;
+        }
+    }
+    tiles_ready = true;
+    return true;
+}
+
+// The scalar spans are kept one pixel at a time: at -O3 GCC would turn
+// these loops into vector code or a memcpy call, and the scalar variant
+// would no longer be a baseline for the SIMD one
+__attribute__((optimize("no-tree-vectorize", "no-tree-loop-distribute-patterns")))
+static void copy_span_scalar(uint32_t *dst, const uint32_t *src, int len)
+{
+    for (int i = 0; i < len; i++)
+        dst[i] = src[i];
+}
+
+__attribute__((optimize("no-tree-vectorize", "no-tree-loop-distribute-patterns")))
+static void key_span_scalar(uint32_t *dst, const uint32_t *src, int len)
+{
+    for (int i = 0; i < len; i++)
+    {
+        if (src[i])
+            dst[i] = src[i];
+    }
+}
+
+static void copy_span(uint32_t *dst, const uint32_t *src, int len, bool simd)
+{
+    int i = 0;
+    if (simd)
+    {
+        for (; i + 4 <= len; i += 4)
+            v4i_store((int32_t *)dst + i, v4i_load((const int32_t *)src + i));
+    }
+    copy_span_scalar(dst + i, src + i, len - i);
+}
+
+static void key_span(uint32_t *dst, const uint32_t *src, int len, bool simd)
+{
+    int i = 0;
+    if (simd)
+    {
+        const v4i zero = v4i_set1(0);
+        for (; i + 4 <= len; i += 4)
+        {
+            v4i s = v4i_load((const int32_t *)src + i);
+            v4i d = v4i_load((const int32_t *)dst + i);
+            v4i_store((int32_t *)dst + i, v4i_select(v4i_cmpeq(s, zero), d, s));
+        }
+    }
+    key_span_scalar(dst + i, src + i, len - i);
+}
+
+// One screen row of a layer, walked tile span by tile span
+static void blit_row(uint32_t *dst, const layer_t *layer, int y, bool simd)
+{
+    const tilemap_t *m = layer->map;
+    const tileset_t *set = m->set;
+    const int tsize = 1 << set->log2, tmask = tsize - 1;
+    const int world_w = tsize << m->cols_log2, world_h = tsize << m->rows_log2;
+    int wy = (y + layer->scroll_y) & (world_h - 1);
+    const uint8_t *map_row = m->map + ((wy >> set->log2) << m->cols_log2);
+    const uint32_t *tile_row = set->pixels + ((wy & tmask) << set->log2);
+
+    for (int x = 0; x < VIDEO_WIDTH;)
+    {
+        int wx = (x + layer->scroll_x) & (world_w - 1);
+        int off = wx & tmask;
+        int len = MIN(tsize - off, VIDEO_WIDTH - x);
+        int id = map_row[wx >> set->log2];
+        const uint32_t *src = tile_row + (id << (2 * set->log2)) + off;
+
+        if (set->kind[id] == TILE_OPAQUE)
+            copy_span(dst + x, src, len, simd);
+        else if (set->kind[id] == TILE_MASKED)
+            key_span(dst + x, src, len, simd);
+        x += len;
+    }
+}
+
+static void blit_rows(const tile_job_t *job, int y0, int y1)
+{
+    uint32_t *pixels = (uint32_t *)frame_buf;
+    for (int l = 0; l < job->count; l++)
+        for (int y = y0; y < y1; y++)
+            blit_row(pixels + y * VIDEO_WIDTH, &job->layers[l], y, job->simd);
+}
+
+static void tile_job(int index, void *arg)
+{
+    int y0 = index * ROWS_PER_JOB;
+    blit_rows((const tile_job_t *)arg, y0, MIN(y0 + ROWS_PER_JOB, VIDEO_HEIGHT));
+}
+
+// Parallax tile-map scroller: an opaque 16x16 sky, masked 16x16 mountains
+// and hills, and an 8x8 foreground, each scrolling at its own speed. Higher
+// stress levels stack extra copies of the masked layers. The demo time is
+// split between a scalar row blit, a SIMD blit and SIMD across the pool.
+void render_tilemap(float time)
+{
+    static layer_t *layers = NULL;
+    static int layers_capacity = 0;
+    static const float speed[LAYER_TYPES] = {12.0f, 30.0f, 60.0f, 120.0f};
+    char label[40];
+    int threads = thread_count();
+    int variant = demo_variant(time, 3);
+    int count = LAYER_TYPES * options.stress;
+
+    if (!tiles_ready && !build_tiles())
+    {
+        draw_text_bg(32, 144, "TILEMAP: OUT OF MEMORY", 0xFFFFFFFF);
+        return;
+    }
+
+    if (layers_capacity < count)
+    {
+        layer_t *grown = (layer_t *)realloc(layers, count * sizeof(layer_t));
+        if (!grown)
+        {
+            draw_text_bg(32, 144, "TILEMAP: OUT OF MEMORY", 0xFFFFFFFF);
+            return;
+        }
+        layers = grown;
+        layers_capacity = count;
+    }
+
+    // Repeated layers skip the sky, which would hide everything behind it
+    for (int i = 0; i < count; i++)
+    {
+        int type = i < LAYER_TYPES ? i : 1 + (i - LAYER_TYPES) % (LAYER_TYPES - 1);
+        float s = speed[type] * (1.0f + 0.1f * (i / LAYER_TYPES));
+        layers[i].map = &maps[type];
+        layers[i].scroll_x = (int)(time * s) + i * 97;
+        layers[i].scroll_y = type == 3 ? 24 + (int)(8.0f * sinf(time * 1.3f)) : 0;
+    }
+
+    tile_job_t job = {layers, count, variant > 0};
+
+    uint64_t t0 = get_time_usec();
+    if (variant == 2)
+        run_parallel(threads, (VIDEO_HEIGHT + ROWS_PER_JOB - 1) / ROWS_PER_JOB, tile_job, &job);
+    else
+        blit_rows(&job, 0, VIDEO_HEIGHT);
+    uint64_t t1 = get_time_usec();
+
+    switch (variant)
+    {
+        case 0:
+            snprintf(label, sizeof(label), "LAYER PIXELS/S (SCALAR)");
+            break;
+        case 1:
+            snprintf(label, sizeof(label), "LAYER PIXELS/S (%s)", SIMD_NAME);
+            break;
+        default:
+            snprintf(label, sizeof(label), "LAYER PIXELS/S (%s, %d THREAD%s)", SIMD_NAME, threads,
+                     threads > 1 ? "S" : "");
+            break;
+    }
+    add_demo_stat(variant, label, (double)count * VIDEO_PIXELS, t1 - t0);
+}
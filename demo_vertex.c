@@ -0,0 +1,315 @@
+#include "pibench.h"
+#include "simd.h"
+
+#define MAX_VERTS (1 << 21)
+#define SIZE_COUNT 4
+#define VARIANT_COUNT 5
+#define CHUNKS_PER_THREAD 4
+#define MAX_POINTS_DRAWN 65536
+
+// 12 bytes in and 12 bytes out per vertex: from L1-resident to DRAM-bound
+static const int sizes[SIZE_COUNT] = {1 << 10, 1 << 14, 1 << 17, 1 << 21};
+static const char *size_names[SIZE_COUNT] = {"24KB", "384KB", "3MB", "48MB"};
+
+typedef enum {
+    LAYOUT_NONE,
+    LAYOUT_AOS, // x y z x y z ...
+    LAYOUT_SOA  // x x x ... y y y ... z z z ...
+} layout_t;
+
+typedef struct {
+    mat4_t mvp;
+    int n;
+    int reps;
+    int chunk;
+    bool soa;
+    bool simd;
+} transform_job_t;
+
+static float *in_buf, *out_buf;
+static layout_t layout = LAYOUT_NONE;
+
+static double vertices[VARIANT_COUNT][SIZE_COUNT];
+static uint64_t usecs[VARIANT_COUNT][SIZE_COUNT];
+static float last_time = 0;
+static int frame_counter = 0;
+
+// Spiral galaxy: two arms, denser towards the centre, slightly thick
+static void make_point(uint32_t i, float *x, float *y, float *z)
+{
+    uint32_t h = i * 0x9E3779B9u;
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    float u = (h & 0xFFFF) * (1.0f / 65536.0f);
+    float v = (h >> 16) * (1.0f / 65536.0f);
+
+    float r = 2.2f * u * u + 0.05f;
+    float a = (i & 1) * (float)M_PI + r * 2.5f + (v - 0.5f) * 0.8f / (r + 0.3f);
+    *x = cosf(a) * r;
+    *z = sinf(a) * r;
+    *y = (v - 0.5f) * 0.25f * (1.0f - r / 2.5f);
+}
+
+static bool prepare_input(layout_t wanted)
+{
+    if (!in_buf)
+    {
+        in_buf = (float *)malloc(MAX_VERTS * 3 * sizeof(float));
+        out_buf = (float *)malloc(MAX_VERTS * 3 * sizeof(float));
+        if (!in_buf || !out_buf)
+        {
+            free(in_buf);
+            free(out_buf);
+            in_buf = out_buf = NULL;
+            return false;
+        }
+    }
+    if (layout == wanted)
+        return true;
+
+    for (uint32_t i = 0; i < MAX_VERTS; i++)
+    {
+        float x, y, z;
+        make_point(i, &x, &y, &z);
+        if (wanted == LAYOUT_AOS)
+        {
+            in_buf[i * 3] = x;
+            in_buf[i * 3 + 1] = y;
+            in_buf[i * 3 + 2] = z;
+        }
+        else
+        {
+            in_buf[i] = x;
+            in_buf[MAX_VERTS + i] = y;
+            in_buf[2 * MAX_VERTS + i] = z;
+        }
+    }
+    layout = wanted;
+    return true;
+}
+
+// Clip-space transform, perspective divide and viewport mapping to pixels,
+// with depth mapped to [0, 1]
+static inline void transform_point(const float *m, float x, float y, float z,
+                                   float *sx, float *sy, float *sz)
+{
+    float cx = m[0] * x + m[1] * y + m[2] * z + m[3];
+    float cy = m[4] * x + m[5] * y + m[6] * z + m[7];
+    float cz = m[8] * x + m[9] * y + m[10] * z + m[11];
+    float cw = m[12] * x + m[13] * y + m[14] * z + m[15];
+    float inv_w = 1.0f / cw;
+    *sx = cx * inv_w * (VIDEO_WIDTH / 2) + VIDEO_WIDTH / 2;
+    *sy = VIDEO_HEIGHT / 2 - cy * inv_w * (VIDEO_HEIGHT / 2);
+    *sz = cz * inv_w * 0.5f + 0.5f;
+}
+
+static void transform_aos(const float *m, const float *in, float *out, int i0, int i1)
+{
+    for (int i = i0; i < i1; i++)
+        transform_point(m, in[i * 3], in[i * 3 + 1], in[i * 3 + 2],
+                        &out[i * 3], &out[i * 3 + 1], &out[i * 3 + 2]);
+}
+
+static void transform_soa(const float *m, const float *in, float *out, int i0, int i1)
+{
+    const float *ix = in, *iy = in + MAX_VERTS, *iz = in + 2 * MAX_VERTS;
+    float *ox = out, *oy = out + MAX_VERTS, *oz = out + 2 * MAX_VERTS;
+
+    for (int i = i0; i < i1; i++)
+        transform_point(m, ix[i], iy[i], iz[i], &ox[i], &oy[i], &oz[i]);
+}
+
+typedef struct {
+    v4f m[16];
+} mat4x4_t;
+
+SIMD_KERNEL void transform4(const mat4x4_t *m, v4f x, v4f y, v4f z, v4f *sx, v4f *sy, v4f *sz)
+{
+    const v4f half = v4f_set1(0.5f);
+    const v4f hw = v4f_set1(VIDEO_WIDTH / 2), hh = v4f_set1(VIDEO_HEIGHT / 2);
+    v4f cx = v4f_madd(m->m[0], x, v4f_madd(m->m[1], y, v4f_madd(m->m[2], z, m->m[3])));
+    v4f cy = v4f_madd(m->m[4], x, v4f_madd(m->m[5], y, v4f_madd(m->m[6], z, m->m[7])));
+    v4f cz = v4f_madd(m->m[8], x, v4f_madd(m->m[9], y, v4f_madd(m->m[10], z, m->m[11])));
+    v4f cw = v4f_madd(m->m[12], x, v4f_madd(m->m[13], y, v4f_madd(m->m[14], z, m->m[15])));
+    v4f inv_w = v4f_div(v4f_set1(1.0f), cw);
+    *sx = v4f_madd(v4f_mul(cx, inv_w), hw, hw);
+    *sy = v4f_sub(hh, v4f_mul(v4f_mul(cy, inv_w), hh));
+    *sz = v4f_madd(v4f_mul(cz, inv_w), half, half);
+}
+
+// The AoS kernel pays for de-interleaving xyz into lanes and back
+SIMD_KERNEL void transform_aos_simd_body(const mat4x4_t *m, const float *in, float *out, int i0, int i1)
+{
+    for (int i = i0; i < i1; i += 4)
+    {
+        v4f x, y, z, sx, sy, sz;
+        v4f_load3(in + i * 3, &x, &y, &z);
+        transform4(m, x, y, z, &sx, &sy, &sz);
+        v4f_store3(out + i * 3, sx, sy, sz);
+    }
+}
+
+SIMD_KERNEL void transform_soa_simd_body(const mat4x4_t *m, const float *in, float *out, int i0, int i1)
+{
+    const float *ix = in, *iy = in + MAX_VERTS, *iz = in + 2 * MAX_VERTS;
+    float *ox = out, *oy = out + MAX_VERTS, *oz = out + 2 * MAX_VERTS;
+
+    for (int i = i0; i < i1; i += 4)
+    {
+        v4f sx, sy, sz;
+        transform4(m, v4f_load(ix + i), v4f_load(iy + i), v4f_load(iz + i), &sx, &sy, &sz);
+        v4f_store(ox + i, sx);
+        v4f_store(oy + i, sy);
+        v4f_store(oz + i, sz);
+    }
+}
+
+SIMD_CLONES(transform_aos_simd, (const mat4x4_t *m, const float *in, float *out, int i0, int i1),
+            (m, in, out, i0, i1))
+SIMD_CLONES(transform_soa_simd, (const mat4x4_t *m, const float *in, float *out, int i0, int i1),
+            (m, in, out, i0, i1))
+
+static void transform_job(int index, void *arg)
+{
+    const transform_job_t *job = (const transform_job_t *)arg;
+    int i0 = index * job->chunk;
+    int i1 = MIN(i0 + job->chunk, job->n);
+    mat4x4_t m4;
+
+    for (int i = 0; i < 16; i++)
+        m4.m[i] = v4f_set1(job->mvp.m[i]);
+
+    for (int r = 0; r < job->reps; r++)
+    {
+        if (job->simd && job->soa)
+            SIMD_CALL(transform_soa_simd, (&m4, in_buf, out_buf, i0, i1));
+        else if (job->simd)
+            SIMD_CALL(transform_aos_simd, (&m4, in_buf, out_buf, i0, i1));
+        else if (job->soa)
+            transform_soa(job->mvp.m, in_buf, out_buf, i0, i1);
+        else
+            transform_aos(job->mvp.m, in_buf, out_buf, i0, i1);
+    }
+}
+
+// Plot transformed points, brighter when closer to the camera
+static void draw_points(bool soa)
+{
+    uint32_t *pixels = (uint32_t *)frame_buf;
+
+    for (int i = 0; i < MAX_POINTS_DRAWN; i++)
+    {
+        float sx, sy, sz;
+        if (soa)
+            sx = out_buf[i], sy = out_buf[MAX_VERTS + i], sz = out_buf[2 * MAX_VERTS + i];
+        else
+            sx = out_buf[i * 3], sy = out_buf[i * 3 + 1], sz = out_buf[i * 3 + 2];
+
+        int x = (int)sx, y = (int)sy;
+        if (x < 0 || x >= VIDEO_WIDTH || y < 0 || y >= VIDEO_HEIGHT)
+            continue;
+
+        int level = MIN(MAX((int)((1.0f - sz) * 8000.0f), 64), 255);
+        pixels[y * VIDEO_WIDTH + x] = 0xFF000000 | (level << 16) | (level << 8) | MIN(level + 48, 255);
+    }
+}
+
+static void draw_table(const char names[][32])
+{
+    char buf[80], rate[16];
+    int x = 32, y = 144;
+
+    int len = snprintf(buf, sizeof(buf), "%-24s", "VERTICES/S");
+    for (int s = 0; s < SIZE_COUNT; s++)
+        len += snprintf(buf + len, sizeof(buf) - len, " %7s", size_names[s]);
+    draw_text_bg(x, y, buf, 0xFFFFFFFF);
+
+    for (int v = 0; v < VARIANT_COUNT; v++)
+    {
+        len = snprintf(buf, sizeof(buf), "%-24s", names[v]);
+        for (int s = 0; s < SIZE_COUNT; s++)
+        {
+            if (usecs[v][s])
+                format_si(rate, sizeof(rate), vertices[v][s] * 1000000.0 / usecs[v][s]);
+            else
+                snprintf(rate, sizeof(rate), "-");
+            len += snprintf(buf + len, sizeof(buf) - len, " %7s", rate);
+        }
+        draw_text_bg(x, y + 8 + v * 8, buf, 0xFFFFFFFF);
+    }
+}
+
+// Transform a point cloud to screen space with a 4x4 matrix, perspective
+// divide and viewport mapping. The demo time is split between AoS and SoA
+// layouts with scalar and SIMD kernels, then SoA SIMD across the worker
+// pool. Each frame transforms 2M vertices from one working-set size.
+void render_vertex(float time)
+{
+    char names[VARIANT_COUNT][32];
+    char label[sizeof("VERTICES/S ()") + sizeof(names[0])];
+    int threads = thread_count();
+    int variant = demo_variant(time, VARIANT_COUNT);
+    bool soa = variant & 1 || variant == 4;
+
+    if (time < last_time)
+    {
+        memset(vertices, 0, sizeof(vertices));
+        memset(usecs, 0, sizeof(usecs));
+    }
+    last_time = time;
+
+    if (!prepare_input(soa ? LAYOUT_SOA : LAYOUT_AOS))
+    {
+        draw_text_bg(32, 144, "VERTEX: OUT OF MEMORY", 0xFFFFFFFF);
+        return;
+    }
+
+    for (int v = 0; v < VARIANT_COUNT; v++)
+    {
+        if (v < 4)
+            snprintf(names[v], sizeof(names[v]), "%s %s", v & 1 ? "SOA" : "AOS", v < 2 ? "SCALAR" : simd_level_name());
+        else
+            snprintf(names[v], sizeof(names[v]), "SOA %s, %d THREAD%s", simd_level_name(), threads,
+                     threads > 1 ? "S" : "");
+    }
+
+    mat4_t proj = mat4_perspective(50.0f * M_PI / 180.0f, (float)VIDEO_WIDTH / VIDEO_HEIGHT, 0.1f, 100.0f);
+    mat4_t view = mat4_translate(0.0f, 0.0f, -5.0f);
+    mat4_t tilt = mat4_rotate_x(0.5f + 0.3f * sinf(time * 0.3f));
+    mat4_t spin = mat4_rotate_y(time * 0.5f);
+    mat4_t model = mat4_mul(&tilt, &spin);
+    mat4_t view_proj = mat4_mul(&proj, &view);
+
+    int s = frame_counter++ % SIZE_COUNT;
+    int n = sizes[s];
+    transform_job_t job = {mat4_mul(&view_proj, &model), n, MAX_VERTS / n, n, soa, variant >= 2};
+
+    uint64_t t0 = get_time_usec();
+    if (variant == 4)
+    {
+        // Each chunk repeats on one thread so small sets stay in that core's cache
+        job.chunk = MAX((n / (threads * CHUNKS_PER_THREAD)) & ~3, 4);
+        run_parallel(threads, (n + job.chunk - 1) / job.chunk, transform_job, &job);
+    }
+    else
+        transform_job(0, &job);
+    uint64_t t1 = get_time_usec();
+
+    vertices[variant][s] += (double)n * job.reps;
+    usecs[variant][s] += t1 - t0;
+
+    snprintf(label, sizeof(label), "VERTICES/S (%s)", names[variant]);
+    add_demo_stat(variant, label, (double)n * job.reps, t1 - t0);
+
+    // Small sets still show the whole cloud; the extra points are not timed
+    if (n < MAX_POINTS_DRAWN)
+    {
+        if (soa)
+            transform_soa(job.mvp.m, in_buf, out_buf, n, MAX_POINTS_DRAWN);
+        else
+            transform_aos(job.mvp.m, in_buf, out_buf, n, MAX_POINTS_DRAWN);
+    }
+    draw_points(soa);
+    draw_table(names);
+}
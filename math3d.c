@@ -0,0 +1,95 @@
+#include "pibench.h"
+
+// Row-major 4x4 matrices acting on column vectors: v' = M * v
+
+mat4_t mat4_identity(void)
+{
+    mat4_t r = {{1, 0, 0, 0,
+                 0, 1, 0, 0,
+                 0, 0, 1, 0,
+                 0, 0, 0, 1}};
+    return r;
+}
+
+mat4_t mat4_mul(const mat4_t *a, const mat4_t *b)
+{
+    mat4_t r;
+    for (int i = 0; i < 4; i++)
+    {
+        for (int j = 0; j < 4; j++)
+        {
+            r.m[i * 4 + j] = a->m[i * 4 + 0] * b->m[0 * 4 + j] +
+                             a->m[i * 4 + 1] * b->m[1 * 4 + j] +
+                             a->m[i * 4 + 2] * b->m[2 * 4 + j] +
+                             a->m[i * 4 + 3] * b->m[3 * 4 + j];
+        }
+    }
+    return r;
+}
+
+// OpenGL-style projection: camera looks down -z, clip-space z in [-w, w]
+mat4_t mat4_perspective(float fovy, float aspect, float znear, float zfar)
+{
+    float f = 1.0f / tanf(fovy * 0.5f);
+    mat4_t r = {{f / aspect, 0, 0, 0,
+                 0, f, 0, 0,
+                 0, 0, (zfar + znear) / (znear - zfar), 2.0f * zfar * znear / (znear - zfar),
+                 0, 0, -1, 0}};
+    return r;
+}
+
+mat4_t mat4_translate(float x, float y, float z)
+{
+    mat4_t r = mat4_identity();
+    r.m[3] = x;
+    r.m[7] = y;
+    r.m[11] = z;
+    return r;
+}
+
+mat4_t mat4_scale(float s)
+{
+    mat4_t r = mat4_identity();
+    r.m[0] = r.m[5] = r.m[10] = s;
+    return r;
+}
+
+mat4_t mat4_rotate_x(float a)
+{
+    mat4_t r = mat4_identity();
+    r.m[5] = cosf(a);
+    r.m[6] = -sinf(a);
+    r.m[9] = sinf(a);
+    r.m[10] = cosf(a);
+    return r;
+}
+
+mat4_t mat4_rotate_y(float a)
+{
+    mat4_t r = mat4_identity();
+    r.m[0] = cosf(a);
+    r.m[2] = sinf(a);
+    r.m[8] = -sinf(a);
+    r.m[10] = cosf(a);
+    return r;
+}
+
+mat4_t mat4_rotate_z(float a)
+{
+    mat4_t r = mat4_identity();
+    r.m[0] = cosf(a);
+    r.m[1] = -sinf(a);
+    r.m[4] = sinf(a);
+    r.m[5] = cosf(a);
+    return r;
+}
+
+vec4_t mat4_transform(const mat4_t *m, float x, float y, float z)
+{
+    vec4_t r;
+    r.x = m->m[0] * x + m->m[1] * y + m->m[2] * z + m->m[3];
+    r.y = m->m[4] * x + m->m[5] * y + m->m[6] * z + m->m[7];
+    r.z = m->m[8] * x + m->m[9] * y + m->m[10] * z + m->m[11];
+    r.w = m->m[12] * x + m->m[13] * y + m->m[14] * z + m->m[15];
+    return r;
+}
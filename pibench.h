@@ -24,30 +24,193 @@
 #define VIDEO_PIXELS VIDEO_WIDTH * VIDEO_HEIGHT
 #define WARM_UP_FPS 2      // Number of warm up frames
 #define DEMO_TIME 15
+#define MAX_DEMO_STATS 8   // Throughput counters a demo can show under the overlay
+#define MAX_CPUS 64        // CPUs the topology scan and affinity code track
 
 typedef enum {
     STATE_MENU,
     STATE_DEMO_HELIX,
     STATE_DEMO_LASER,
     STATE_DEMO_RADIAL_LINES,
+    STATE_DEMO_RADIAL_LINES_AA,
+    STATE_DEMO_RADIAL_LINES_MT,
     STATE_DEMO_NOISE,
+    STATE_DEMO_PERLIN,
+    STATE_DEMO_FILL,
+    STATE_DEMO_SGEMM,
+    STATE_DEMO_FFT,
+    STATE_DEMO_MESH,
+    STATE_DEMO_VERTEX,
+    STATE_DEMO_TEXTURE,
+    STATE_DEMO_TILEMAP,
+    STATE_DEMO_SPRITES,
+    STATE_DEMO_COMPOSITE,
+    STATE_DEMO_LZ,
+    STATE_DEMO_HASH,
+    STATE_DEMO_LATENCY,
+    STATE_DEMO_SCALING,
     STATE_DEMO_RESULTS
 } app_state_t;
 
+// Where the render thread and the workers may run
+typedef enum {
+    AFFINITY_OFF,    // Leave placement to the scheduler
+    AFFINITY_SPREAD, // One thread per core, fastest cluster first
+    AFFINITY_BIG,    // Only the fastest cluster
+    AFFINITY_LITTLE  // Only the slowest cluster
+} affinity_t;
+
+// What a finished run does with pibench_baseline.txt
+typedef enum {
+    BASELINE_COMPARE, // Show deltas against it
+    BASELINE_UPDATE,  // Replace it with this run
+    BASELINE_OFF
+} baseline_mode_t;
+
+typedef struct {
+    bool laser_sampled;    // Stamp squares at fixed samples instead of exact thick lines
+    bool laser_packed;     // Accumulate laser hits in a nibble-packed buffer
+    int stress;            // Workload multiplier for scalable demos (1 = default)
+    bool scaling;          // Run the multi-core scaling sweep before the results
+    affinity_t affinity;   // Thread placement across CPU clusters
+    int soak_minutes;      // Soak test length, 0 = normal single pass
+    int soak_demo;         // State looped by the soak, 0 = the whole sequence
+    baseline_mode_t baseline; // Comparison against a saved run
+    bool simd_baseline;    // Keep the baseline-ISA kernels on CPUs with a faster level
+} core_options_t;
+
+typedef struct {
+    float x0, y0, x1, y1;
+    uint32_t color;
+} line_t;
+
+// Inclusive clip window in pixels
+typedef struct {
+    int x0, y0, x1, y1;
+} clip_rect_t;
+
+typedef void (*job_fn_t)(int index, void *arg);
+
+// CPUs of equal capacity, e.g. the A76 or A55 cores of an RK3588
+typedef struct {
+    char name[20];
+    int capacity;    // cpu_capacity, else max clock in MHz, 0 if unknown
+    bool efficiency; // Listed under /sys/devices/cpu_atom on Intel hybrids
+    int count;
+    int cpus[MAX_CPUS];
+} cpu_cluster_t;
+
+typedef struct {
+    float m[16];
+} mat4_t;
+
+typedef struct {
+    float x, y, z, w;
+} vec4_t;
+
 extern uint8_t *frame_buf;
 extern struct retro_perf_callback perf;
+extern core_options_t options;
+extern char retro_base_directory[4096];
 
 int get_cpu_core_count(void);
 float get_cpu_temperature(void);
+float get_cpu_frequency(void);
 float get_cpu_usage(void);
 float get_process_cpu_usage(void);
 void draw_text_alpha(int, int, const char *, uint32_t);
 void draw_text_bg(int, int, const char *, uint32_t);
+void fill_span(uint32_t *, int, uint32_t);
+void draw_lines(const line_t *, int);
+void draw_lines_clipped(const line_t *, int, const clip_rect_t *);
+void draw_lines_aa(const line_t *, int);
+
+uint64_t get_time_usec(void);
+int demo_variant(float, int);
+void force_last_variant(bool);
+void add_demo_stat(int, const char *, double, uint64_t);
+void reset_demo_stats(void);
+double get_demo_stat(int);
+void sample_demo_stats(void);
+double get_demo_stat_cv(int, int *);
+const char *get_demo_stat_label(int);
+const char *state_name(int);
+void draw_demo_stats(int, int);
+bool format_demo_stats(char *, size_t);
+void format_si(char *, size_t, double);
+uint32_t hash32(uint32_t);
+
+mat4_t mat4_identity(void);
+mat4_t mat4_mul(const mat4_t *, const mat4_t *);
+mat4_t mat4_perspective(float, float, float, float);
+mat4_t mat4_translate(float, float, float);
+mat4_t mat4_scale(float);
+mat4_t mat4_rotate_x(float);
+mat4_t mat4_rotate_y(float);
+mat4_t mat4_rotate_z(float);
+vec4_t mat4_transform(const mat4_t *, float, float, float);
+
+void threads_init(void);
+void threads_deinit(void);
+int thread_count(void);
+void set_thread_limit(int);
+void set_thread_affinity(affinity_t);
+
+void topology_init(void);
+int cpu_cluster_count(void);
+const cpu_cluster_t *get_cpu_cluster(int);
+void format_topology(char *, size_t);
+int affinity_cpu(affinity_t, int);
+int affinity_thread_cap(affinity_t);
+void sample_residency(void);
+void reset_residency(void);
+bool format_residency(char *, size_t);
+void run_parallel(int, int, job_fn_t, void *);
 
 void render_helix(float);
 void render_radial_lines(float);
+void render_radial_lines_aa(float);
+void render_radial_lines_mt(float);
 void render_laser(float);
 void render_noise(float);
-//void render_test(float);
+void render_perlin(float);
+void render_fill(float);
+void render_sgemm(float);
+void render_fft(float);
+void render_mesh(float);
+void render_vertex(float);
+void render_texture(float);
+void render_tilemap(float);
+void render_sprites(float);
+void render_composite(float);
+void render_lz(float);
+void lz_capture_frame(void);
+void render_hash(float);
+void render_latency(float);
+void reset_results(void);
+void sample_results(float);
+void record_demo_results(int);
+void finish_results(baseline_mode_t, void (*)(const char *));
+void draw_baseline_results(int, int);
+void reset_score(void);
+void record_score(int, double);
+void finish_score(void);
+bool format_score(char *, size_t);
+void draw_score(int, int);
+
+void soak_start(int, int);
+bool soak_running(void);
+bool soak_finished(void);
+bool soak_time_up(void);
+int soak_demo(void);
+void soak_sample(int, float, float, float, float);
+void soak_stop(void);
+bool format_soak_summary(char *, size_t);
+void draw_soak_graph(void);
+void draw_soak_summary(int, int);
+
+void render_scaling(float);
+float scaling_duration(void);
+void draw_scaling_results(int, int);
 
 #endif
\ No newline at end of file
@@ -1,10 +1,12 @@
 #include "pibench.h"
+#include "simd.h"
 #include "font.h"
 #include "libretro.h"
 
 // Global extern
 uint8_t *frame_buf;
 struct retro_perf_callback perf;
+core_options_t options;
 
 // Retro callbacks
 static retro_environment_t environ_cb;
@@ -53,6 +55,9 @@ static void fallback_log(enum retro_log_level level, const char *fmt, ...)
 void retro_init(void)
 {
     frame_buf = (uint8_t *)aligned_alloc(16, VIDEO_PIXELS * sizeof(uint32_t));
+    topology_init();
+    threads_init();
+    simd_init(true);
 
     const char *dir = NULL;
     if (environ_cb(RETRO_ENVIRONMENT_GET_SYSTEM_DIRECTORY, &dir) && dir)
@@ -75,6 +80,7 @@ void retro_init(void)
 
 void retro_deinit(void)
 {
+    threads_deinit();
     free(frame_buf);
     frame_buf = NULL;
 }
@@ -132,6 +138,21 @@ void retro_set_environment(retro_environment_t cb)
     };
 
     cb(RETRO_ENVIRONMENT_SET_CONTROLLER_INFO, (void *)ports);
+
+    static const struct retro_variable vars[] = {
+        {"pibench_laser_lines", "Laser line rasterizer; sampled|exact"},
+        {"pibench_laser_buffer", "Laser accumulation buffer; byte|nibble"},
+        {"pibench_stress", "Stress level; 1|2|4|8|16"},
+        {"pibench_scaling", "Multi-core scaling sweep; disabled|enabled"},
+        {"pibench_affinity", "Thread affinity; off|spread|big|little"},
+        {"pibench_soak", "Soak test minutes; disabled|10|20|30|60"},
+        {"pibench_baseline", "Baseline comparison; compare|update|off"},
+        {"pibench_simd", "SIMD kernels; auto|baseline"},
+        {"pibench_soak_demo", "Soak test demo; sequence|helix|laser|radial_lines|radial_lines_aa|radial_lines_mt|noise|perlin|fill|sgemm|fft|mesh|vertex|texture|tilemap|sprites|composite|lz|hash|latency"},
+        {NULL, NULL},
+    };
+
+    cb(RETRO_ENVIRONMENT_SET_VARIABLES, (void *)vars);
 }
 
 void retro_set_audio_sample(retro_audio_sample_t cb)
@@ -175,6 +196,7 @@ static void reset_vars()
     //total_single_cpu = 0;
     start_time = 0;
     current_time = 0;
+    reset_demo_stats();
 }
 
 static void update_input(void)
@@ -185,13 +207,57 @@ static void update_input(void)
         if (input_state_cb(0, RETRO_DEVICE_JOYPAD, 0, RETRO_DEVICE_ID_JOYPAD_START))
         {
             reset_vars();
-            current_state = STATE_DEMO_HELIX;
+            reset_residency();
+            reset_results();
+            soak_start(options.soak_minutes, options.soak_demo);
+            current_state = options.soak_minutes && options.soak_demo ? options.soak_demo : STATE_DEMO_HELIX;
         }
     }
 }
 
+static const char *get_variable(const char *key)
+{
+    struct retro_variable var = {key, NULL};
+    if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+        return var.value;
+    return "";
+}
+
 static void check_variables(void)
 {
+    options.laser_sampled = strcmp(get_variable("pibench_laser_lines"), "exact") != 0;
+    options.laser_packed = !strcmp(get_variable("pibench_laser_buffer"), "nibble");
+    options.stress = MAX(atoi(get_variable("pibench_stress")), 1);
+    options.scaling = !strcmp(get_variable("pibench_scaling"), "enabled");
+
+    const char *affinity = get_variable("pibench_affinity");
+    if (!strcmp(affinity, "spread"))
+        options.affinity = AFFINITY_SPREAD;
+    else if (!strcmp(affinity, "big"))
+        options.affinity = AFFINITY_BIG;
+    else if (!strcmp(affinity, "little"))
+        options.affinity = AFFINITY_LITTLE;
+    else
+        options.affinity = AFFINITY_OFF;
+    set_thread_affinity(options.affinity);
+
+    const char *baseline = get_variable("pibench_baseline");
+    if (!strcmp(baseline, "update"))
+        options.baseline = BASELINE_UPDATE;
+    else if (!strcmp(baseline, "off"))
+        options.baseline = BASELINE_OFF;
+    else
+        options.baseline = BASELINE_COMPARE;
+
+    options.simd_baseline = !strcmp(get_variable("pibench_simd"), "baseline");
+    simd_init(!options.simd_baseline);
+
+    const char *soak_demo = get_variable("pibench_soak_demo");
+    options.soak_minutes = MAX(atoi(get_variable("pibench_soak")), 0);
+    options.soak_demo = 0;
+    for (int state = STATE_DEMO_HELIX; state < STATE_DEMO_SCALING; state++)
+        if (!strcmp(soak_demo, state_name(state)))
+            options.soak_demo = state;
 }
 
 static void audio_callback(void)
@@ -203,6 +269,11 @@ static void audio_set_state(bool enable)
     (void)enable;
 }
 
+static void log_line(const char *line)
+{
+    log_cb(RETRO_LOG_INFO, "%s\n", line);
+}
+
 static void draw_info(void)
 {
     // Display on-screen info in top left
@@ -213,6 +284,7 @@ static void draw_info(void)
     draw_text_bg(32, 64, cpu_multi_avg_str, 0xFFFFFFFF);
     draw_text_bg(32, 72, cpu_single_avg_str, 0xFFFFFFFF);
     draw_text_bg(32, 80, temp_str, 0xFFFFFFFF);
+    draw_demo_stats(32, 88);
 }
 
 static void draw_results(void)
@@ -228,11 +300,35 @@ static void draw_results(void)
     draw_text_bg(x, y+24, cpu_single_avg_str, 0xFFFFFFFF);
     draw_text_bg(x, y+32, temp_str, 0xFFFFFFFF);
 
+    // SIMD level, topology, placement and where the render thread actually ran
+    static const char *affinity_names[] = {"OFF", "SPREAD", "BIG CLUSTER", "LITTLE CLUSTER"};
+    char buf[96], residency[64];
+    format_topology(residency, sizeof(residency));
+    snprintf(buf, sizeof(buf), "SIMD KERNELS: %s", simd_level_name());
+    draw_text_bg(x, y+40, buf, 0xFFFFFFFF);
+    snprintf(buf, sizeof(buf), "CPUS: %s", residency);
+    draw_text_bg(x, y+48, buf, 0xFFFFFFFF);
+    snprintf(buf, sizeof(buf), "THREAD AFFINITY: %s", affinity_names[options.affinity]);
+    draw_text_bg(x, y+56, buf, 0xFFFFFFFF);
+    if (cpu_cluster_count() > 1 && format_residency(residency, sizeof(residency)))
+    {
+        snprintf(buf, sizeof(buf), "RENDER THREAD ON: %s", residency);
+        draw_text_bg(x, y+64, buf, 0xFFFFFFFF);
+    }
+
     msg = "PRESS START TO RESTART SOFTWARE PERFORMANCE TEST";
     msg_width = strlen(msg) * 8;
     x = (VIDEO_WIDTH - msg_width) / 2;
     y = VIDEO_HEIGHT / 2 - 4;
     draw_text_bg(x, y, msg, 0xFFFFFFFF);
+
+    draw_score(16, 24);
+    draw_baseline_results(VIDEO_WIDTH / 3, 152);
+
+    if (soak_finished())
+        draw_soak_summary(16, y + 24);
+    else
+        draw_scaling_results(16, y + 24);
 }
 
 void retro_run(void)
@@ -283,22 +379,118 @@ void retro_run(void)
             render_radial_lines(current_time);
             draw_info();
             break;
+        case STATE_DEMO_RADIAL_LINES_AA:
+            render_radial_lines_aa(current_time);
+            draw_info();
+            break;
+        case STATE_DEMO_RADIAL_LINES_MT:
+            render_radial_lines_mt(current_time);
+            draw_info();
+            break;
         case STATE_DEMO_NOISE:
             render_noise(current_time);
             draw_info();
             break;
+        case STATE_DEMO_PERLIN:
+            render_perlin(current_time);
+            draw_info();
+            break;
+        case STATE_DEMO_FILL:
+            render_fill(current_time);
+            draw_info();
+            break;
+        case STATE_DEMO_SGEMM:
+            render_sgemm(current_time);
+            draw_info();
+            break;
+        case STATE_DEMO_FFT:
+            render_fft(current_time);
+            draw_info();
+            break;
+        case STATE_DEMO_MESH:
+            render_mesh(current_time);
+            draw_info();
+            break;
+        case STATE_DEMO_VERTEX:
+            render_vertex(current_time);
+            draw_info();
+            break;
+        case STATE_DEMO_TEXTURE:
+            render_texture(current_time);
+            draw_info();
+            break;
+        case STATE_DEMO_TILEMAP:
+            render_tilemap(current_time);
+            draw_info();
+            break;
+        case STATE_DEMO_SPRITES:
+            render_sprites(current_time);
+            draw_info();
+            break;
+        case STATE_DEMO_COMPOSITE:
+            render_composite(current_time);
+            draw_info();
+            break;
+        case STATE_DEMO_LZ:
+            render_lz(current_time);
+            draw_info();
+            break;
+        case STATE_DEMO_HASH:
+            render_hash(current_time);
+            draw_info();
+            break;
+        case STATE_DEMO_LATENCY:
+            render_latency(current_time);
+            draw_info();
+            break;
+        case STATE_DEMO_SCALING:
+            render_scaling(current_time);
+            draw_info();
+            break;
         case STATE_DEMO_RESULTS:
             // Draw menu text
             draw_results();
             break;
     }
 
+    if (soak_running())
+        draw_soak_graph();
+
     if (current_state != STATE_MENU && 
         current_state != STATE_DEMO_RESULTS && 
-        current_time >= DEMO_TIME)
+        current_time >= (current_state == STATE_DEMO_SCALING ? scaling_duration() : DEMO_TIME))
     {
+        record_demo_results(current_state);
         reset_vars();
-        current_state++;
+
+        // A soak loops one demo or the whole sequence until its time is up
+        if (soak_running() && soak_time_up())
+        {
+            char summary[256];
+            soak_stop();
+            if (format_soak_summary(summary, sizeof(summary)))
+                log_cb(RETRO_LOG_INFO, "%s\n", summary);
+            current_state = STATE_DEMO_RESULTS;
+        }
+        else if (!soak_running() || !soak_demo())
+        {
+            current_state++;
+
+            // The previous demo's last frame is one of the LZ inputs
+            if (current_state == STATE_DEMO_LZ)
+                lz_capture_frame();
+
+            // The sweep is opt-in, it takes a second per demo and thread
+            // count, and it would break up the steady load of a soak
+            if (current_state == STATE_DEMO_SCALING && (!options.scaling || soak_running()))
+                current_state++;
+
+            if (current_state == STATE_DEMO_RESULTS && soak_running())
+                current_state = STATE_DEMO_HELIX;
+        }
+
+        if (current_state == STATE_DEMO_RESULTS)
+            finish_results(options.baseline, log_line);
     }
 
     // Submit frame
@@ -315,6 +507,7 @@ void retro_run(void)
     {
         // Update counters
         fps++;
+        sample_residency();
 
         // Log every second
         if (frame_end - last_log_time >= 1000000)
@@ -358,6 +551,8 @@ void retro_run(void)
             {
                 strncpy(temp_str, "CPU TEMPERATURE: ---C", sizeof(temp_str));
             }
+
+            soak_sample(current_state, current_time, fps, temp, get_cpu_frequency());
 #endif
 
             // Update FPS display string
@@ -379,6 +574,15 @@ void retro_run(void)
                 cpu_single_avg_str,
                 temp_str);
 
+            sample_demo_stats();
+            sample_results(fps);
+
+            char stats_str[512];
+            if (format_demo_stats(stats_str, sizeof(stats_str)))
+                log_cb(RETRO_LOG_INFO, "%s\n", stats_str);
+            if (cpu_cluster_count() > 1 && format_residency(stats_str, sizeof(stats_str)))
+                log_cb(RETRO_LOG_INFO, "Render thread on: %s\n", stats_str);
+
             // Reset counters
             last_log_time = frame_end;
             fps = 0;
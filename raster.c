@@ -0,0 +1,378 @@
+#include "pibench.h"
+#include "simd.h"
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Fill count 32-bit pixels: align to 16 bytes, then four vector stores per step
+SIMD_KERNEL void fill_span_body(uint32_t *dst, int count, uint32_t color)
+{
+    while (count > 0 && ((uintptr_t)dst & 15))
+    {
+        *dst++ = color;
+        count--;
+    }
+
+    v4i c = v4i_set1((int32_t)color);
+    int32_t *p = (int32_t *)dst;
+    for (; count >= 16; count -= 16, p += 16)
+    {
+        v4i_store(p, c);
+        v4i_store(p + 4, c);
+        v4i_store(p + 8, c);
+        v4i_store(p + 12, c);
+    }
+    for (; count >= 4; count -= 4, p += 4)
+        v4i_store(p, c);
+
+    dst = (uint32_t *)p;
+    while (count-- > 0)
+        *dst++ = color;
+}
+
+SIMD_CLONES(fill_span, (uint32_t *dst, int count, uint32_t color), (dst, count, color))
+
+void fill_span(uint32_t *dst, int count, uint32_t color)
+{
+    SIMD_CALL(fill_span, (dst, count, color));
+}
+
+// Endpoints are truncated to ints; keep them well inside int range
+#define COORD_LIMIT 1048576.0f
+
+static const clip_rect_t viewport = {0, 0, VIDEO_WIDTH - 1, VIDEO_HEIGHT - 1};
+
+static inline int64_t floor_div(int64_t a, int64_t b)
+{
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+static inline int64_t ceil_div(int64_t a, int64_t b)
+{
+    return -floor_div(-a, b);
+}
+
+static inline int to_coord(float v)
+{
+    return (int)fmaxf(fminf(v, COORD_LIMIT), -COORD_LIMIT);
+}
+
+// Restrict the step range [lo, hi] so that p0 + s * i stays within [min, max]
+static inline void clip_steps(int p0, int s, int min, int max, int64_t *lo, int64_t *hi)
+{
+    if (s > 0)
+    {
+        *lo = MAX(*lo, (int64_t)min - p0);
+        *hi = MIN(*hi, (int64_t)max - p0);
+    }
+    else
+    {
+        *lo = MAX(*lo, (int64_t)p0 - max);
+        *hi = MIN(*hi, (int64_t)p0 - min);
+    }
+}
+
+// Bresenham line in parametric form: step i along the major axis (am steps
+// in total) puts the minor axis at k(i) = floor((2 * i * an + am) / (2 * am)).
+// Clipping works Liang-Barsky style on i: each window edge bounds the step
+// range, so the clipped line hits exactly the pixels the full line would.
+typedef struct {
+    int64_t first, count; // Steps to draw
+    int64_t minor;        // k(first)
+    int64_t err;          // Remainder of k(first), in units of 1 / (2 * am)
+} line_clip_t;
+
+static bool clip_line(int m0, int n0, int am, int an, int sm, int sn,
+                      int mmin, int mmax, int nmin, int nmax, line_clip_t *out)
+{
+    int64_t lo = 0, hi = am;
+    clip_steps(m0, sm, mmin, mmax, &lo, &hi);
+
+    // Minor axis: bound k first, then map the k range back onto i
+    int64_t klo = 0, khi = an;
+    clip_steps(n0, sn, nmin, nmax, &klo, &khi);
+    if (klo > khi)
+        return false;
+    if (an > 0)
+    {
+        lo = MAX(lo, ceil_div(2 * (int64_t)am * klo - am, 2 * (int64_t)an));
+        hi = MIN(hi, floor_div(2 * (int64_t)am * (khi + 1) - am - 1, 2 * (int64_t)an));
+    }
+    if (lo > hi)
+        return false;
+
+    int64_t num = 2 * lo * an + am;
+    int64_t wrap = MAX(2 * (int64_t)am, 1); // Zero-length lines are a single pixel
+    out->first = lo;
+    out->count = hi - lo + 1;
+    out->minor = num / wrap;
+    out->err = num % wrap;
+    return true;
+}
+
+static void draw_x_major(uint32_t *p, int64_t count, int64_t err, int am, int an,
+                         int sx, int row_step, uint32_t color)
+{
+    const int64_t inc = 2 * (int64_t)an;
+    const int64_t wrap = 2 * (int64_t)am;
+
+    while (count-- > 0)
+    {
+        *p = color;
+        p += sx;
+        err += inc;
+        if (err >= wrap)
+        {
+            err -= wrap;
+            p += row_step;
+        }
+    }
+}
+
+static void draw_y_major(uint32_t *p, int64_t count, int64_t err, int am, int an,
+                         int sx, int row_step, uint32_t color)
+{
+    const int64_t inc = 2 * (int64_t)an;
+    const int64_t wrap = 2 * (int64_t)am;
+
+    while (count-- > 0)
+    {
+        *p = color;
+        p += row_step;
+        err += inc;
+        if (err >= wrap)
+        {
+            err -= wrap;
+            p += sx;
+        }
+    }
+}
+
+static void draw_line_clipped(const line_t *line, const clip_rect_t *clip)
+{
+    int x0 = to_coord(line->x0), y0 = to_coord(line->y0);
+    int x1 = to_coord(line->x1), y1 = to_coord(line->y1);
+
+    // Trivial reject (both endpoints beyond the same window edge)
+    if ((x0 < clip->x0 && x1 < clip->x0) || (x0 > clip->x1 && x1 > clip->x1) ||
+        (y0 < clip->y0 && y1 < clip->y0) || (y0 > clip->y1 && y1 > clip->y1))
+        return;
+
+    int ax = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+    int ay = abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+    uint32_t *fb = (uint32_t *)frame_buf;
+    line_clip_t c;
+
+    if (ax >= ay)
+    {
+        if (!clip_line(x0, y0, ax, ay, sx, sy, clip->x0, clip->x1, clip->y0, clip->y1, &c))
+            return;
+        int x = x0 + sx * (int)c.first;
+        int y = y0 + sy * (int)c.minor;
+        draw_x_major(fb + y * VIDEO_WIDTH + x, c.count, c.err, ax, ay,
+                     sx, sy * VIDEO_WIDTH, line->color);
+    }
+    else
+    {
+        if (!clip_line(y0, x0, ay, ax, sy, sx, clip->y0, clip->y1, clip->x0, clip->x1, &c))
+            return;
+        int y = y0 + sy * (int)c.first;
+        int x = x0 + sx * (int)c.minor;
+        draw_y_major(fb + y * VIDEO_WIDTH + x, c.count, c.err, ay, ax,
+                     sx, sy * VIDEO_WIDTH, line->color);
+    }
+}
+
+// Draw a batch of opaque 1-pixel lines, each clipped to the screen once
+void draw_lines(const line_t *lines, int count)
+{
+    draw_lines_clipped(lines, count, &viewport);
+}
+
+// Same, clipped to a window inside the screen. Pixels match the unclipped
+// lines exactly, so disjoint windows can be drawn from different threads.
+void draw_lines_clipped(const line_t *lines, int count, const clip_rect_t *clip)
+{
+    for (int i = 0; i < count; i++)
+        draw_line_clipped(&lines[i], clip);
+}
+
+// dst = (src * a + dst * (255 - a)) / 255 per channel, two channels per multiply
+static inline uint32_t blend_pixel(uint32_t dst, uint32_t src, unsigned a)
+{
+    uint32_t na = 255 - a;
+    uint32_t rb = (src & 0x00FF00FF) * a + (dst & 0x00FF00FF) * na + 0x00800080;
+    uint32_t ag = ((src >> 8) & 0x00FF00FF) * a + ((dst >> 8) & 0x00FF00FF) * na + 0x00800080;
+    rb = ((rb + ((rb >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+    ag = (ag + ((ag >> 8) & 0x00FF00FF)) & 0xFF00FF00;
+    return rb | ag;
+}
+
+// Blend the two pixels of a Wu step in one vector, each with its own coverage
+static inline void blend_pair(uint32_t *p0, uint32_t *p1, uint32_t color, unsigned a0, unsigned a1)
+{
+#if defined(__ARM_NEON)
+    uint32x2_t d = vset_lane_u32(*p1, vdup_n_u32(*p0), 1);
+    uint32x2_t a = vset_lane_u32(a1 * 0x01010101u, vdup_n_u32(a0 * 0x01010101u), 1);
+    uint8x8_t alpha = vreinterpret_u8_u32(a);
+    uint16x8_t acc = vmull_u8(vreinterpret_u8_u32(vdup_n_u32(color)), alpha);
+    acc = vmlal_u8(acc, vreinterpret_u8_u32(d), vmvn_u8(alpha));
+    uint32x2_t out = vreinterpret_u32_u8(vraddhn_u16(acc, vrshrq_n_u16(acc, 8)));
+    *p0 = vget_lane_u32(out, 0);
+    *p1 = vget_lane_u32(out, 1);
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    __m128i d = _mm_unpacklo_epi32(_mm_cvtsi32_si128(*p0), _mm_cvtsi32_si128(*p1));
+    __m128i alpha = _mm_set_epi16(a1, a1, a1, a1, a0, a0, a0, a0);
+    __m128i acc = _mm_mullo_epi16(_mm_unpacklo_epi8(_mm_set1_epi32(color), zero), alpha);
+    acc = _mm_add_epi16(acc, _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero),
+                                             _mm_sub_epi16(_mm_set1_epi16(255), alpha)));
+    acc = _mm_add_epi16(acc, _mm_set1_epi16(128));
+    acc = _mm_srli_epi16(_mm_add_epi16(acc, _mm_srli_epi16(acc, 8)), 8);
+    __m128i out = _mm_packus_epi16(acc, zero);
+    *p0 = _mm_cvtsi128_si32(out);
+    *p1 = _mm_cvtsi128_si32(_mm_srli_si128(out, 4));
+#else
+    *p0 = blend_pixel(*p0, color, a0);
+    *p1 = blend_pixel(*p1, color, a1);
+#endif
+}
+
+// Xiaolin Wu line: step i along the major axis sits at minor offset
+// k = acc >> 16 with acc = i * adj in 16.16 fixed point, and the fraction
+// splits coverage between that pixel and the next one along the minor axis
+typedef struct {
+    int m0, n0, sm, sn;  // Start and direction on the major/minor axes
+    bool x_major;
+    int major_step, minor_step;
+    uint64_t adj;
+    uint32_t color;
+} wu_line_t;
+
+static inline int64_t wu_first_step(uint64_t adj, int64_t k)
+{
+    return ceil_div(k * 65536, (int64_t)adj); // First i with (i * adj) >> 16 >= k
+}
+
+static inline uint32_t *wu_pixel(const wu_line_t *w, int64_t i, int64_t k)
+{
+    int m = w->m0 + w->sm * (int)i;
+    int n = w->n0 + w->sn * (int)k;
+    int x = w->x_major ? m : n;
+    int y = w->x_major ? n : m;
+    return (uint32_t *)frame_buf + y * VIDEO_WIDTH + x;
+}
+
+static void wu_steps(const wu_line_t *w, int64_t first, int64_t last)
+{
+    uint64_t acc = first * w->adj;
+    uint32_t *p = wu_pixel(w, first, acc >> 16);
+
+    for (int64_t i = first; i <= last; i++)
+    {
+        unsigned frac = (acc >> 8) & 0xFF;
+        blend_pair(p, p + w->minor_step, w->color, 255 - frac, frac);
+
+        uint64_t next = acc + w->adj;
+        p += w->major_step + (int)((next >> 16) - (acc >> 16)) * w->minor_step;
+        acc = next;
+    }
+}
+
+// Steps where one of the two pixels falls outside the window
+static void wu_steps_checked(const wu_line_t *w, int64_t first, int64_t last,
+                             int64_t klo, int64_t khi)
+{
+    for (int64_t i = first; i <= last; i++)
+    {
+        uint64_t acc = i * w->adj;
+        int64_t k = acc >> 16;
+        unsigned frac = (acc >> 8) & 0xFF;
+        if (k >= klo && k <= khi)
+        {
+            uint32_t *q = wu_pixel(w, i, k);
+            *q = blend_pixel(*q, w->color, 255 - frac);
+        }
+        if (k + 1 >= klo && k + 1 <= khi)
+        {
+            uint32_t *q = wu_pixel(w, i, k + 1);
+            *q = blend_pixel(*q, w->color, frac);
+        }
+    }
+}
+
+static void draw_line_aa_clipped(const line_t *line, const clip_rect_t *clip)
+{
+    int x0 = to_coord(line->x0), y0 = to_coord(line->y0);
+    int x1 = to_coord(line->x1), y1 = to_coord(line->y1);
+
+    if ((x0 < clip->x0 && x1 < clip->x0) || (x0 > clip->x1 && x1 > clip->x1) ||
+        (y0 < clip->y0 && y1 < clip->y0) || (y0 > clip->y1 && y1 > clip->y1))
+        return;
+
+    int ax = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+    int ay = abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+    bool x_major = ax >= ay;
+    int am = x_major ? ax : ay, an = x_major ? ay : ax;
+
+    wu_line_t w;
+    w.x_major = x_major;
+    w.m0 = x_major ? x0 : y0;
+    w.n0 = x_major ? y0 : x0;
+    w.sm = x_major ? sx : sy;
+    w.sn = x_major ? sy : sx;
+    w.major_step = x_major ? sx : sy * VIDEO_WIDTH;
+    w.minor_step = x_major ? sy * VIDEO_WIDTH : sx;
+    w.adj = am ? ((uint64_t)an << 16) / am : 0;
+    w.color = line->color;
+
+    // Pixel offsets along the minor axis run from 0 to an + 1
+    int64_t lo = 0, hi = am;
+    int64_t klo = 0, khi = an + 1;
+    if (x_major)
+    {
+        clip_steps(w.m0, w.sm, clip->x0, clip->x1, &lo, &hi);
+        clip_steps(w.n0, w.sn, clip->y0, clip->y1, &klo, &khi);
+    }
+    else
+    {
+        clip_steps(w.m0, w.sm, clip->y0, clip->y1, &lo, &hi);
+        clip_steps(w.n0, w.sn, clip->x0, clip->x1, &klo, &khi);
+    }
+    if (klo > khi || lo > hi)
+        return;
+
+    // Steps with at least one pixel inside, then the subset with both inside
+    int64_t vis_lo = lo, vis_hi = hi;
+    int64_t in_lo = lo, in_hi = hi;
+    if (w.adj)
+    {
+        vis_lo = MAX(lo, wu_first_step(w.adj, klo - 1));
+        vis_hi = MIN(hi, wu_first_step(w.adj, khi + 1) - 1);
+        in_lo = MAX(lo, wu_first_step(w.adj, klo));
+        in_hi = MIN(hi, wu_first_step(w.adj, khi) - 1);
+    }
+    else if (klo > 0 || khi < 1)
+    {
+        in_lo = hi + 1; // Horizontal pair straddles the window edge
+    }
+
+    if (in_lo > in_hi)
+    {
+        wu_steps_checked(&w, vis_lo, vis_hi, klo, khi);
+        return;
+    }
+    wu_steps_checked(&w, vis_lo, in_lo - 1, klo, khi);
+    wu_steps(&w, in_lo, in_hi);
+    wu_steps_checked(&w, in_hi + 1, vis_hi, klo, khi);
+}
+
+// Draw a batch of anti-aliased lines blended over the frame buffer
+void draw_lines_aa(const line_t *lines, int count)
+{
+    for (int i = 0; i < count; i++)
+        draw_line_aa_clipped(&lines[i], &viewport);
+}
@@ -0,0 +1,303 @@
+#include "pibench.h"
+#include "simd.h"
+
+#define MAX_RESULTS 256
+#define MIN_DELTA 0.02     // Changes under 2% are never called
+#define UNKNOWN_DELTA 0.05 // Threshold when a side has no noise estimate
+#define NOISE_SIGMAS 3.0   // Standard errors a change must clear
+#define SHOWN_CHANGES 8    // Largest changes listed on the results screen
+
+// One metric of a run: a demo stat, or a demo's average FPS
+typedef struct {
+    char key[80];  // "<demo>: AVERAGE FPS" or "<demo>/<slot>: <label>"
+    double value;
+    double cv;     // Spread of the per-second values, -1 if unknown
+    int count;     // Seconds behind value and cv
+    int threads;   // Thread count named by the label, 0 if none
+} result_t;
+
+typedef enum {
+    VERDICT_NOISE,
+    VERDICT_IMPROVED,
+    VERDICT_REGRESSED
+} verdict_t;
+
+typedef struct {
+    const result_t *current, *base;
+    double delta; // Relative change, e.g. -0.05 for 5% slower
+    verdict_t verdict;
+} comparison_t;
+
+static result_t results[MAX_RESULTS];
+static int result_count = 0;
+static result_t baseline[MAX_RESULTS];
+static int baseline_count = 0;
+static comparison_t comparisons[MAX_RESULTS];
+static int comparison_count = 0;
+static char baseline_path[4200];
+
+// Per-second FPS of the running demo
+static double fps_sum = 0, fps_sum_sq = 0;
+static int fps_count = 0;
+
+static void results_path(char *buf, size_t size, const char *file)
+{
+    if (retro_base_directory[0])
+        snprintf(buf, size, "%s/%s", retro_base_directory, file);
+    else
+        snprintf(buf, size, "%s", file);
+}
+
+void reset_results(void)
+{
+    reset_score();
+    result_count = 0;
+    comparison_count = 0;
+    fps_sum = fps_sum_sq = 0;
+    fps_count = 0;
+}
+
+void sample_results(float fps)
+{
+    fps_sum += fps;
+    fps_sum_sq += (double)fps * fps;
+    fps_count++;
+}
+
+// Stat labels carry the live thread count, e.g. "FLOPS (SSE2, 4 THREADS)".
+// The key form swaps the count for "N", so one metric matches across
+// hosts with different core counts; the count is returned separately.
+static int split_threads(const char *label, char *stable, size_t size)
+{
+    const char *word = strstr(label, " THREAD");
+    const char *digits = word;
+
+    while (digits && digits > label && digits[-1] >= '0' && digits[-1] <= '9')
+        digits--;
+    if (!word || digits == word)
+    {
+        snprintf(stable, size, "%s", label);
+        return 0;
+    }
+
+    const char *rest = word + strlen(" THREAD");
+    if (*rest == 'S')
+        rest++;
+    snprintf(stable, size, "%.*sN THREADS%s", (int)(digits - label), label, rest);
+    return atoi(digits);
+}
+
+// Later passes (soak loops) replace earlier ones. Stats are keyed by slot
+// as well, since a 1-thread host gives the serial and pooled slots of a
+// demo the same label.
+static void add_result(const char *demo, int slot, const char *label, double value, double cv, int count)
+{
+    char key[80], stable[40];
+    int i = 0;
+
+    int threads = split_threads(label, stable, sizeof(stable));
+    if (slot < 0)
+        snprintf(key, sizeof(key), "%.20s: %.39s", demo, stable);
+    else
+        snprintf(key, sizeof(key), "%.20s/%d: %.39s", demo, slot, stable);
+    while (i < result_count && strcmp(results[i].key, key))
+        i++;
+    if (i == MAX_RESULTS)
+        return;
+    if (i == result_count)
+        result_count++;
+    snprintf(results[i].key, sizeof(results[i].key), "%s", key);
+    results[i].value = value;
+    results[i].cv = cv;
+    results[i].count = count;
+    results[i].threads = threads;
+}
+
+// Keep every stat of a demo that is about to end, plus its average FPS.
+// The scaling sweep has results of its own.
+void record_demo_results(int state)
+{
+    const char *demo = state == STATE_DEMO_SCALING ? NULL : state_name(state);
+
+    if (demo && fps_count > 0)
+    {
+        double mean = fps_sum / fps_count;
+        double var = fmax(fps_sum_sq / fps_count - mean * mean, 0.0);
+        add_result(demo, -1, "AVERAGE FPS", mean, (fps_count > 1 && mean > 0) ? sqrt(var) / mean : -1, fps_count);
+        record_score(state, mean);
+
+        for (int slot = 0; slot < MAX_DEMO_STATS; slot++)
+        {
+            int count;
+            const char *label = get_demo_stat_label(slot);
+            double cv = get_demo_stat_cv(slot, &count);
+            if (label && get_demo_stat(slot) > 0)
+                add_result(demo, slot, label, get_demo_stat(slot), cv, count);
+        }
+    }
+    fps_sum = fps_sum_sq = 0;
+    fps_count = 0;
+}
+
+// Tab-separated "key value cv seconds threads" lines after a header comment
+static bool write_results(const char *path)
+{
+    FILE *f = fopen(path, "w");
+    if (!f)
+        return false;
+    fprintf(f, "# pibench results (%s kernels): metric\tvalue\tcv\tseconds\tthreads\n", simd_level_name());
+    for (int i = 0; i < result_count; i++)
+        fprintf(f, "%s\t%.6g\t%.4f\t%d\t%d\n", results[i].key, results[i].value, results[i].cv, results[i].count,
+                results[i].threads);
+    fclose(f);
+    return true;
+}
+
+static bool read_baseline(const char *path)
+{
+    char line[256];
+    FILE *f = fopen(path, "r");
+
+    baseline_count = 0;
+    if (!f)
+        return false;
+    while (fgets(line, sizeof(line), f) && baseline_count < MAX_RESULTS)
+    {
+        char *value = strchr(line, '\t');
+        if (line[0] == '#' || !value)
+            continue;
+        *value++ = '\0';
+
+        result_t *r = &baseline[baseline_count];
+        r->threads = 0;
+        if (sscanf(value, "%lf\t%lf\t%d\t%d", &r->value, &r->cv, &r->count, &r->threads) < 3 || r->value <= 0)
+            continue;
+        snprintf(r->key, sizeof(r->key), "%.79s", line);
+        baseline_count++;
+    }
+    fclose(f);
+    return baseline_count > 0;
+}
+
+// A change counts when it clears NOISE_SIGMAS standard errors of the
+// difference, estimated from both runs' per-second spread, and MIN_DELTA
+static verdict_t judge(const result_t *current, const result_t *base, double delta)
+{
+    double threshold = UNKNOWN_DELTA;
+    if (current->cv >= 0 && base->cv >= 0 && current->count > 1 && base->count > 1)
+    {
+        double se = sqrt(current->cv * current->cv / current->count + base->cv * base->cv / base->count);
+        threshold = fmax(NOISE_SIGMAS * se, MIN_DELTA);
+    }
+    if (fabs(delta) < threshold)
+        return VERDICT_NOISE;
+    return delta > 0 ? VERDICT_IMPROVED : VERDICT_REGRESSED;
+}
+
+static int by_change(const void *a, const void *b)
+{
+    const comparison_t *x = (const comparison_t *)a, *y = (const comparison_t *)b;
+    bool x_real = x->verdict != VERDICT_NOISE, y_real = y->verdict != VERDICT_NOISE;
+    if (x_real != y_real)
+        return x_real ? -1 : 1;
+    double dx = fabs(x->delta), dy = fabs(y->delta);
+    return (dx < dy) - (dx > dy);
+}
+
+static void compare_results(void)
+{
+    comparison_count = 0;
+    for (int i = 0; i < result_count; i++)
+    {
+        for (int j = 0; j < baseline_count; j++)
+        {
+            if (strcmp(results[i].key, baseline[j].key))
+                continue;
+            comparison_t *c = &comparisons[comparison_count++];
+            c->current = &results[i];
+            c->base = &baseline[j];
+            c->delta = results[i].value / baseline[j].value - 1.0;
+            c->verdict = judge(c->current, c->base, c->delta);
+            break;
+        }
+    }
+    qsort(comparisons, comparison_count, sizeof(comparisons[0]), by_change);
+}
+
+static const char *verdict_name(verdict_t verdict)
+{
+    return verdict == VERDICT_IMPROVED ? "IMPROVED" : verdict == VERDICT_REGRESSED ? "REGRESSED" : "NOISE";
+}
+
+// Called when a run reaches the results screen. This run always goes to
+// pibench_results.txt and is scored. With "compare" it is checked against
+// pibench_baseline.txt; with "update" it replaces that file instead.
+void finish_results(baseline_mode_t mode, void (*log)(const char *))
+{
+    char path[4200], line[256];
+
+    results_path(path, sizeof(path), "pibench_results.txt");
+    write_results(path);
+
+    finish_score();
+    if (format_score(line, sizeof(line)))
+        log(line);
+
+    comparison_count = 0;
+    baseline_path[0] = '\0';
+    results_path(path, sizeof(path), "pibench_baseline.txt");
+    if (mode == BASELINE_UPDATE)
+    {
+        if (write_results(path))
+            snprintf(baseline_path, sizeof(baseline_path), "%s", path);
+        return;
+    }
+    if (mode != BASELINE_COMPARE || !read_baseline(path))
+        return;
+    snprintf(baseline_path, sizeof(baseline_path), "%s", path);
+
+    compare_results();
+    for (int i = 0; i < comparison_count; i++)
+    {
+        const comparison_t *c = &comparisons[i];
+        int len = snprintf(line, sizeof(line), "Baseline %s: %.4g -> %.4g (%+.1f%%, %s)", c->current->key,
+                           c->base->value, c->current->value, c->delta * 100.0, verdict_name(c->verdict));
+        if (c->current->threads != c->base->threads && len < (int)sizeof(line))
+            snprintf(line + len, sizeof(line) - len, " on %d threads, baseline %d", c->current->threads,
+                     c->base->threads);
+        log(line);
+    }
+}
+
+// Verdict counts and the largest changes against the baseline, or where
+// the baseline was saved to
+void draw_baseline_results(int x, int y)
+{
+    static const uint32_t colors[] = {0xFFC2C3C7, 0xFF00E436, 0xFFFF004D};
+    char buf[96];
+    int counts[3] = {0};
+
+    if (!baseline_path[0])
+        return;
+    if (!comparison_count)
+    {
+        size_t len = strlen(baseline_path);
+        snprintf(buf, sizeof(buf), "BASELINE SAVED TO %s%.24s", len > 24 ? "..." : "",
+                 baseline_path + (len > 24 ? len - 24 : 0));
+        draw_text_bg(x, y, buf, 0xFFFFFFFF);
+        return;
+    }
+
+    for (int i = 0; i < comparison_count; i++)
+        counts[comparisons[i].verdict]++;
+    snprintf(buf, sizeof(buf), "VS BASELINE: %d REGRESSED, %d IMPROVED, %d NOISE",
+             counts[VERDICT_REGRESSED], counts[VERDICT_IMPROVED], counts[VERDICT_NOISE]);
+    draw_text_bg(x, y, buf, 0xFFFFFFFF);
+
+    for (int i = 0; i < MIN(comparison_count, SHOWN_CHANGES); i++)
+    {
+        const comparison_t *c = &comparisons[i];
+        snprintf(buf, sizeof(buf), "%-24.24s %+6.1f%%", c->current->key, c->delta * 100.0);
+        draw_text_bg(x, y + 8 + i * 8, buf, colors[c->verdict]);
+    }
+}
@@ -0,0 +1,190 @@
+#include "pibench.h"
+
+#define DEMO_COUNT (STATE_DEMO_SCALING - STATE_DEMO_HELIX)
+#define SCORE_SCALE 1000.0 // The reference board scores 1000
+
+// Options that change what the FPS headlines measure, as recorded with
+// the built-in reference rates
+#define BUILTIN_SETTINGS "stress=1 laser_lines=sampled laser_buffer=byte simd=auto"
+
+// Headline throughput of each demo: its multithreaded (or most portable)
+// stat slot, or the frame rate for demos without stats (-1)
+typedef struct {
+    int slot;
+    double reference; // Rate on the reference board
+} headline_t;
+
+// Reference rates at BUILTIN_SETTINGS, from the x86-64 development VM
+// (one core) the demos were tuned on, without vsync. A pibench_score.txt
+// from any other board, copied to pibench_reference.txt, replaces them.
+static const headline_t headlines[DEMO_COUNT] = {
+    {-1, 5530},      // helix: FPS
+    {-1, 1200},      // laser: FPS
+    {-1, 12900},     // radial_lines: FPS
+    {-1, 8400},      // radial_lines_aa: FPS
+    {1, 2.17e6},     // radial_lines_mt: LINES/S, all threads
+    {-1, 42.9},      // noise: FPS
+    {2, 1.33e7},     // perlin: PIXELS/S, SIMD on all threads
+    {0, 3.42e9},     // fill: PIXELS/S FILLED
+    {5, 1.68e10},    // sgemm: FLOPS, best kernel on all threads
+    {4, 7.26e9},     // fft: FLOPS, all threads
+    {2, 4.66e6},     // mesh: TRIS/S, all threads
+    {4, 5.45e8},     // vertex: VERTICES/S, all threads
+    {6, 5.38e7},     // texture: PIXELS/S, all threads
+    {2, 1.64e9},     // tilemap: PIXELS/S, all threads
+    {2, 2.08e6},     // sprites: SPRITES/S, all threads
+    {3, 4.25e8},     // composite: PIXELS/S, all threads
+    {2, 3.58e8},     // lz: compression BYTES/S, all threads
+    {3, 5.63e9},     // hash: BYTES/S, XXH64
+    {0, 3.32e6},     // latency: LOADS/S, normal pages
+};
+
+static double rates[DEMO_COUNT];
+static double references[DEMO_COUNT];
+static bool custom_reference = false;
+static char settings[96];
+static char reference_settings[96];
+static double score = 0;
+static int scored = 0;
+
+void reset_score(void)
+{
+    memset(rates, 0, sizeof(rates));
+    score = 0;
+    scored = 0;
+}
+
+// Keep the headline rate of a demo that is about to end; `fps` is its
+// average frame rate
+void record_score(int state, double fps)
+{
+    int d = state - STATE_DEMO_HELIX;
+    if (d < 0 || d >= DEMO_COUNT)
+        return;
+    rates[d] = headlines[d].slot < 0 ? fps : get_demo_stat(headlines[d].slot);
+}
+
+// The stress level scales the line demos and the laser variants change
+// its frame cost, so a score is only comparable at the same settings
+static void format_settings(char *buf, size_t size)
+{
+    snprintf(buf, size, "stress=%d laser_lines=%s laser_buffer=%s simd=%s", options.stress,
+             options.laser_sampled ? "sampled" : "exact", options.laser_packed ? "nibble" : "byte",
+             options.simd_baseline ? "baseline" : "auto");
+}
+
+static void load_references(void)
+{
+    char path[4200], line[128];
+
+    for (int d = 0; d < DEMO_COUNT; d++)
+        references[d] = headlines[d].reference;
+    custom_reference = false;
+    snprintf(reference_settings, sizeof(reference_settings), "%s", BUILTIN_SETTINGS);
+
+    if (retro_base_directory[0])
+        snprintf(path, sizeof(path), "%s/pibench_reference.txt", retro_base_directory);
+    else
+        snprintf(path, sizeof(path), "pibench_reference.txt");
+    FILE *f = fopen(path, "r");
+    if (!f)
+        return;
+
+    while (fgets(line, sizeof(line), f))
+    {
+        if (!strncmp(line, "# settings: ", 12))
+        {
+            line[strcspn(line, "\n")] = '\0';
+            snprintf(reference_settings, sizeof(reference_settings), "%.*s",
+                     (int)sizeof(reference_settings) - 1, line + 12);
+            continue;
+        }
+        char *value = strchr(line, '\t');
+        if (line[0] == '#' || !value)
+            continue;
+        *value++ = '\0';
+        double rate = strtod(value, NULL);
+        for (int d = 0; d < DEMO_COUNT; d++)
+        {
+            if (rate > 0 && !strcmp(line, state_name(STATE_DEMO_HELIX + d)))
+            {
+                references[d] = rate;
+                custom_reference = true;
+            }
+        }
+    }
+    fclose(f);
+}
+
+// Geometric mean of rate / reference over the demos that ran, so a demo
+// twice as fast moves the score by the same factor whichever it is. Also
+// writes pibench_score.txt, whose first two columns make a reference file.
+void finish_score(void)
+{
+    char path[4200];
+    double log_sum = 0;
+
+    load_references();
+    format_settings(settings, sizeof(settings));
+    scored = 0;
+    for (int d = 0; d < DEMO_COUNT; d++)
+    {
+        if (rates[d] > 0 && references[d] > 0)
+        {
+            log_sum += log(rates[d] / references[d]);
+            scored++;
+        }
+    }
+    score = scored ? SCORE_SCALE * exp(log_sum / scored) : 0;
+
+    if (retro_base_directory[0])
+        snprintf(path, sizeof(path), "%s/pibench_score.txt", retro_base_directory);
+    else
+        snprintf(path, sizeof(path), "pibench_score.txt");
+    FILE *f = fopen(path, "w");
+    if (!f)
+        return;
+    fprintf(f, "# pibench score %.0f: demo\trate\treference\tpoints\n", score);
+    fprintf(f, "# settings: %s\n", settings);
+    for (int d = 0; d < DEMO_COUNT; d++)
+        if (rates[d] > 0)
+            fprintf(f, "%s\t%.6g\t%.6g\t%.0f\n", state_name(STATE_DEMO_HELIX + d), rates[d], references[d],
+                    references[d] > 0 ? SCORE_SCALE * rates[d] / references[d] : 0);
+    fclose(f);
+}
+
+bool format_score(char *buf, size_t size)
+{
+    if (!scored)
+        return false;
+    snprintf(buf, size, "Composite score %.0f (%d of %d demos, %s reference%s)", score, scored, DEMO_COUNT,
+             custom_reference ? "custom" : "built-in",
+             strcmp(settings, reference_settings) ? ", settings differ from it" : "");
+    return true;
+}
+
+// Headline score over one line per demo with its own points, i.e. 1000
+// times its rate against the reference; the score is their geometric mean
+void draw_score(int x, int y)
+{
+    char buf[64];
+
+    if (!scored)
+        return;
+
+    snprintf(buf, sizeof(buf), "SCORE %.0f", score);
+    draw_text_bg(x, y, buf, 0xFFFFEC27);
+    snprintf(buf, sizeof(buf), "%d/%d DEMOS, %s REF", scored, DEMO_COUNT, custom_reference ? "CUSTOM" : "BUILT-IN");
+    draw_text_bg(x, y + 8, buf, 0xFFC2C3C7);
+    if (strcmp(settings, reference_settings))
+        draw_text_bg(x, y + 16, "SETTINGS DIFFER FROM REF", 0xFFFF004D);
+
+    for (int d = 0, row = 0; d < DEMO_COUNT; d++)
+    {
+        if (rates[d] <= 0 || references[d] <= 0)
+            continue;
+        double points = SCORE_SCALE * rates[d] / references[d];
+        snprintf(buf, sizeof(buf), "%-15s %6.0f", state_name(STATE_DEMO_HELIX + d), points);
+        draw_text_bg(x, y + 24 + row++ * 8, buf, points >= SCORE_SCALE ? 0xFF00E436 : 0xFFFF004D);
+    }
+}
@@ -0,0 +1,22 @@
+#include "pibench.h"
+#include "simd.h"
+
+bool simd_fast = false;
+
+// The fast clones need AVX2 with FMA; on other targets there is only the
+// baseline level. `allow_fast` false keeps the baseline clones for
+// comparison runs.
+void simd_init(bool allow_fast)
+{
+    bool supported = false;
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    supported = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+    simd_fast = allow_fast && supported;
+}
+
+const char *simd_level_name(void)
+{
+    return simd_fast ? SIMD_FAST_NAME : SIMD_NAME;
+}
@@ -0,0 +1,254 @@
+#ifndef SIMD_H__
+#define SIMD_H__
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <stdbool.h>
+
+// Minimal 4-lane float/int vector layer: NEON on ARM, SSE2 on x86, plain C elsewhere
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define SIMD_NAME "NEON"
+typedef float32x4_t v4f;
+typedef int32x4_t v4i;
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SIMD_NAME "SSE2"
+typedef __m128 v4f;
+typedef __m128i v4i;
+#else
+#define SIMD_NAME "C"
+typedef struct { float v[4]; } v4f;
+typedef struct { int32_t v[4]; } v4i;
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+
+static inline v4f v4f_load(const float *p) { return vld1q_f32(p); }
+static inline void v4f_store(float *p, v4f a) { vst1q_f32(p, a); }
+static inline v4f v4f_set1(float x) { return vdupq_n_f32(x); }
+static inline v4f v4f_set(float a, float b, float c, float d)
+{
+    float t[4] = {a, b, c, d};
+    return vld1q_f32(t);
+}
+static inline v4f v4f_add(v4f a, v4f b) { return vaddq_f32(a, b); }
+static inline v4f v4f_sub(v4f a, v4f b) { return vsubq_f32(a, b); }
+static inline v4f v4f_mul(v4f a, v4f b) { return vmulq_f32(a, b); }
+static inline v4f v4f_div(v4f a, v4f b) { return vdivq_f32(a, b); }
+static inline v4f v4f_madd(v4f a, v4f b, v4f c) { return vmlaq_f32(c, a, b); }
+static inline v4f v4f_min(v4f a, v4f b) { return vminq_f32(a, b); }
+static inline v4f v4f_max(v4f a, v4f b) { return vmaxq_f32(a, b); }
+static inline v4f v4f_floor(v4f a) { return vrndmq_f32(a); }
+static inline v4i v4f_to_v4i(v4f a) { return vcvtq_s32_f32(a); }
+static inline v4f v4i_to_v4f(v4i a) { return vcvtq_f32_s32(a); }
+static inline v4i v4f_as_v4i(v4f a) { return vreinterpretq_s32_f32(a); }
+static inline v4f v4i_as_v4f(v4i a) { return vreinterpretq_f32_s32(a); }
+
+// Four packed xyz triples <-> one vector per component
+static inline void v4f_load3(const float *p, v4f *x, v4f *y, v4f *z)
+{
+    float32x4x3_t v = vld3q_f32(p);
+    *x = v.val[0];
+    *y = v.val[1];
+    *z = v.val[2];
+}
+static inline void v4f_store3(float *p, v4f x, v4f y, v4f z)
+{
+    float32x4x3_t v = {{x, y, z}};
+    vst3q_f32(p, v);
+}
+
+static inline v4i v4i_load(const int32_t *p) { return vld1q_s32(p); }
+static inline void v4i_store(int32_t *p, v4i a) { vst1q_s32(p, a); }
+static inline v4i v4i_set1(int32_t x) { return vdupq_n_s32(x); }
+static inline v4i v4i_add(v4i a, v4i b) { return vaddq_s32(a, b); }
+static inline v4i v4i_sub(v4i a, v4i b) { return vsubq_s32(a, b); }
+static inline v4i v4i_mul(v4i a, v4i b) { return vmulq_s32(a, b); }
+// Multiply as eight 16-bit lanes, keeping the low half of each product
+static inline v4i v4i_mul16(v4i a, v4i b)
+{
+    return vreinterpretq_s32_u16(vmulq_u16(vreinterpretq_u16_s32(a), vreinterpretq_u16_s32(b)));
+}
+static inline v4i v4i_and(v4i a, v4i b) { return vandq_s32(a, b); }
+static inline v4i v4i_or(v4i a, v4i b) { return vorrq_s32(a, b); }
+static inline v4i v4i_xor(v4i a, v4i b) { return veorq_s32(a, b); }
+static inline v4i v4i_cmpeq(v4i a, v4i b) { return vreinterpretq_s32_u32(vceqq_s32(a, b)); }
+static inline v4i v4i_cmplt(v4i a, v4i b) { return vreinterpretq_s32_u32(vcltq_s32(a, b)); }
+static inline v4f v4f_select(v4i mask, v4f a, v4f b) { return vbslq_f32(vreinterpretq_u32_s32(mask), a, b); }
+static inline v4i v4i_select(v4i mask, v4i a, v4i b) { return vbslq_s32(vreinterpretq_u32_s32(mask), a, b); }
+#define v4i_shl(a, n) vshlq_n_s32((a), (n))
+#define v4i_shr(a, n) vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(a), (n)))
+
+#elif defined(__SSE2__)
+
+static inline v4f v4f_load(const float *p) { return _mm_loadu_ps(p); }
+static inline void v4f_store(float *p, v4f a) { _mm_storeu_ps(p, a); }
+static inline v4f v4f_set1(float x) { return _mm_set1_ps(x); }
+static inline v4f v4f_set(float a, float b, float c, float d) { return _mm_setr_ps(a, b, c, d); }
+static inline v4f v4f_add(v4f a, v4f b) { return _mm_add_ps(a, b); }
+static inline v4f v4f_sub(v4f a, v4f b) { return _mm_sub_ps(a, b); }
+static inline v4f v4f_mul(v4f a, v4f b) { return _mm_mul_ps(a, b); }
+static inline v4f v4f_div(v4f a, v4f b) { return _mm_div_ps(a, b); }
+static inline v4f v4f_madd(v4f a, v4f b, v4f c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+static inline v4f v4f_min(v4f a, v4f b) { return _mm_min_ps(a, b); }
+static inline v4f v4f_max(v4f a, v4f b) { return _mm_max_ps(a, b); }
+static inline v4f v4f_floor(v4f a)
+{
+    // Truncate, then step down where truncation rounded up (negative inputs)
+    v4f t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a));
+    return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, a), _mm_set1_ps(1.0f)));
+}
+static inline v4i v4f_to_v4i(v4f a) { return _mm_cvttps_epi32(a); }
+static inline v4f v4i_to_v4f(v4i a) { return _mm_cvtepi32_ps(a); }
+static inline v4i v4f_as_v4i(v4f a) { return _mm_castps_si128(a); }
+static inline v4f v4i_as_v4f(v4i a) { return _mm_castsi128_ps(a); }
+
+static inline void v4f_load3(const float *p, v4f *x, v4f *y, v4f *z)
+{
+    // a = x0 y0 z0 x1, b = y1 z1 x2 y2, c = z2 x3 y3 z3
+    __m128 a = _mm_loadu_ps(p), b = _mm_loadu_ps(p + 4), c = _mm_loadu_ps(p + 8);
+    __m128 t = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 1, 3, 2));
+    *x = _mm_shuffle_ps(a, t, _MM_SHUFFLE(2, 0, 3, 0));
+    *y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), t, _MM_SHUFFLE(3, 1, 2, 0));
+    *z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)),
+                        _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+}
+static inline void v4f_store3(float *p, v4f x, v4f y, v4f z)
+{
+    __m128 lo = _mm_unpacklo_ps(x, y), hi = _mm_unpackhi_ps(x, y);
+    _mm_storeu_ps(p, _mm_shuffle_ps(lo, _mm_shuffle_ps(z, lo, _MM_SHUFFLE(2, 2, 0, 0)), _MM_SHUFFLE(2, 0, 1, 0)));
+    _mm_storeu_ps(p + 4, _mm_shuffle_ps(_mm_shuffle_ps(lo, z, _MM_SHUFFLE(1, 1, 3, 3)), hi, _MM_SHUFFLE(1, 0, 2, 0)));
+    _mm_storeu_ps(p + 8, _mm_shuffle_ps(_mm_shuffle_ps(z, hi, _MM_SHUFFLE(2, 2, 2, 2)),
+                                        _mm_shuffle_ps(hi, z, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+static inline v4i v4i_load(const int32_t *p) { return _mm_loadu_si128((const __m128i *)p); }
+static inline void v4i_store(int32_t *p, v4i a) { _mm_storeu_si128((__m128i *)p, a); }
+static inline v4i v4i_set1(int32_t x) { return _mm_set1_epi32(x); }
+static inline v4i v4i_add(v4i a, v4i b) { return _mm_add_epi32(a, b); }
+static inline v4i v4i_sub(v4i a, v4i b) { return _mm_sub_epi32(a, b); }
+static inline v4i v4i_mul(v4i a, v4i b)
+{
+    // SSE2 has no 32-bit mullo: multiply even and odd lanes separately
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+static inline v4i v4i_mul16(v4i a, v4i b) { return _mm_mullo_epi16(a, b); }
+static inline v4i v4i_and(v4i a, v4i b) { return _mm_and_si128(a, b); }
+static inline v4i v4i_or(v4i a, v4i b) { return _mm_or_si128(a, b); }
+static inline v4i v4i_xor(v4i a, v4i b) { return _mm_xor_si128(a, b); }
+static inline v4i v4i_cmpeq(v4i a, v4i b) { return _mm_cmpeq_epi32(a, b); }
+static inline v4i v4i_cmplt(v4i a, v4i b) { return _mm_cmplt_epi32(a, b); }
+static inline v4f v4f_select(v4i mask, v4f a, v4f b)
+{
+    v4f m = _mm_castsi128_ps(mask);
+    return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+}
+static inline v4i v4i_select(v4i mask, v4i a, v4i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+#define v4i_shl(a, n) _mm_slli_epi32((a), (n))
+#define v4i_shr(a, n) _mm_srli_epi32((a), (n))
+
+#else
+
+#define V4_MAP(T, expr) \
+    T r;                \
+    for (int i = 0; i < 4; i++) \
+        r.v[i] = (expr);        \
+    return r
+
+static inline v4f v4f_load(const float *p) { v4f r; memcpy(r.v, p, sizeof(r.v)); return r; }
+static inline void v4f_store(float *p, v4f a) { memcpy(p, a.v, sizeof(a.v)); }
+static inline v4f v4f_set1(float x) { V4_MAP(v4f, x); }
+static inline v4f v4f_set(float a, float b, float c, float d) { v4f r = {{a, b, c, d}}; return r; }
+static inline v4f v4f_add(v4f a, v4f b) { V4_MAP(v4f, a.v[i] + b.v[i]); }
+static inline v4f v4f_sub(v4f a, v4f b) { V4_MAP(v4f, a.v[i] - b.v[i]); }
+static inline v4f v4f_mul(v4f a, v4f b) { V4_MAP(v4f, a.v[i] * b.v[i]); }
+static inline v4f v4f_div(v4f a, v4f b) { V4_MAP(v4f, a.v[i] / b.v[i]); }
+static inline v4f v4f_madd(v4f a, v4f b, v4f c) { V4_MAP(v4f, a.v[i] * b.v[i] + c.v[i]); }
+static inline v4f v4f_min(v4f a, v4f b) { V4_MAP(v4f, fminf(a.v[i], b.v[i])); }
+static inline v4f v4f_max(v4f a, v4f b) { V4_MAP(v4f, fmaxf(a.v[i], b.v[i])); }
+static inline v4f v4f_floor(v4f a) { V4_MAP(v4f, floorf(a.v[i])); }
+static inline v4i v4f_to_v4i(v4f a) { V4_MAP(v4i, (int32_t)a.v[i]); }
+static inline v4f v4i_to_v4f(v4i a) { V4_MAP(v4f, (float)a.v[i]); }
+static inline v4i v4f_as_v4i(v4f a) { v4i r; memcpy(r.v, a.v, sizeof(r.v)); return r; }
+static inline v4f v4i_as_v4f(v4i a) { v4f r; memcpy(r.v, a.v, sizeof(r.v)); return r; }
+static inline void v4f_load3(const float *p, v4f *x, v4f *y, v4f *z)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        x->v[i] = p[i * 3];
+        y->v[i] = p[i * 3 + 1];
+        z->v[i] = p[i * 3 + 2];
+    }
+}
+static inline void v4f_store3(float *p, v4f x, v4f y, v4f z)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        p[i * 3] = x.v[i];
+        p[i * 3 + 1] = y.v[i];
+        p[i * 3 + 2] = z.v[i];
+    }
+}
+
+static inline v4i v4i_load(const int32_t *p) { v4i r; memcpy(r.v, p, sizeof(r.v)); return r; }
+static inline void v4i_store(int32_t *p, v4i a) { memcpy(p, a.v, sizeof(a.v)); }
+static inline v4i v4i_set1(int32_t x) { V4_MAP(v4i, x); }
+static inline v4i v4i_add(v4i a, v4i b) { V4_MAP(v4i, (int32_t)((uint32_t)a.v[i] + (uint32_t)b.v[i])); }
+static inline v4i v4i_sub(v4i a, v4i b) { V4_MAP(v4i, (int32_t)((uint32_t)a.v[i] - (uint32_t)b.v[i])); }
+static inline v4i v4i_mul(v4i a, v4i b) { V4_MAP(v4i, (int32_t)((uint32_t)a.v[i] * (uint32_t)b.v[i])); }
+static inline uint32_t mul16_pair(uint32_t a, uint32_t b)
+{
+    return (uint16_t)(a * b) | (uint32_t)(uint16_t)((a >> 16) * (b >> 16)) << 16;
+}
+static inline v4i v4i_mul16(v4i a, v4i b) { V4_MAP(v4i, (int32_t)mul16_pair((uint32_t)a.v[i], (uint32_t)b.v[i])); }
+static inline v4i v4i_and(v4i a, v4i b) { V4_MAP(v4i, a.v[i] & b.v[i]); }
+static inline v4i v4i_or(v4i a, v4i b) { V4_MAP(v4i, a.v[i] | b.v[i]); }
+static inline v4i v4i_xor(v4i a, v4i b) { V4_MAP(v4i, a.v[i] ^ b.v[i]); }
+static inline v4i v4i_cmpeq(v4i a, v4i b) { V4_MAP(v4i, a.v[i] == b.v[i] ? -1 : 0); }
+static inline v4i v4i_cmplt(v4i a, v4i b) { V4_MAP(v4i, a.v[i] < b.v[i] ? -1 : 0); }
+static inline v4f v4f_select(v4i mask, v4f a, v4f b) { V4_MAP(v4f, mask.v[i] ? a.v[i] : b.v[i]); }
+static inline v4i v4i_select(v4i mask, v4i a, v4i b) { V4_MAP(v4i, mask.v[i] ? a.v[i] : b.v[i]); }
+static inline v4i v4i_shl_(v4i a, int n) { V4_MAP(v4i, (int32_t)((uint32_t)a.v[i] << n)); }
+static inline v4i v4i_shr_(v4i a, int n) { V4_MAP(v4i, (int32_t)((uint32_t)a.v[i] >> n)); }
+#define v4i_shl(a, n) v4i_shl_((a), (n))
+#define v4i_shr(a, n) v4i_shr_((a), (n))
+
+#endif
+
+// Runtime dispatch. Hot kernels are written once as a SIMD_KERNEL body and
+// compiled twice by SIMD_CLONES: for the baseline ISA of the build and for
+// SIMD_FAST_TARGET, which lets the compiler use AVX2 and FMA on x86. The
+// ARM build has a single level: the kernels are 128-bit float and 32-bit
+// integer work that ARMv8.0 NEON already covers, and none of them maps
+// onto the ARMv8.2 fp16 or dotprod instructions of the Pi 5's A76.
+// SIMD_CALL picks the clone simd_init() found the CPU can run.
+#if defined(__x86_64__)
+#define SIMD_FAST_TARGET __attribute__((target("avx2,fma")))
+#define SIMD_FAST_NAME "AVX2"
+#else
+#define SIMD_FAST_TARGET
+#define SIMD_FAST_NAME SIMD_NAME
+#endif
+
+#define SIMD_KERNEL static inline __attribute__((always_inline))
+
+#define SIMD_CLONES(name, params, args)                    \
+    static void name##_base params { name##_body args; } \
+    SIMD_FAST_TARGET static void name##_fast params { name##_body args; }
+
+#define SIMD_CALL(name, args) (simd_fast ? name##_fast args : name##_base args)
+
+extern bool simd_fast;
+void simd_init(bool allow_fast);
+const char *simd_level_name(void);
+
+#endif
@@ -0,0 +1,388 @@
+#include "pibench.h"
+
+#define MAX_SAMPLES (60 * 60 + 120) // An hour plus the demo that runs past it
+#define SECONDS_PER_STATE 64        // Baseline slots per demo, one per second
+#define WINDOW 10                   // Seconds in the rolling means that spot throttling
+#define DROP 0.95f                  // Under 95% of the initial level counts as throttled
+#define INITIAL_TIME 60             // Seconds that make up the initial figures
+
+// Series scales for the graph
+#define PERF_MAX 1.25f
+#define TEMP_MIN 20.0f
+#define TEMP_MAX 100.0f
+
+typedef struct {
+    float fps;
+    float relative; // FPS against the first pass over the same demo second
+    float temp;     // Celsius, -1 if unknown
+    float mhz;      // -1 if unknown
+    int state;
+} soak_sample_t;
+
+typedef struct {
+    float perf, fps, temp, mhz;
+} soak_level_t;
+
+static soak_sample_t samples[MAX_SAMPLES];
+static int sample_count = 0;
+static float baseline[STATE_DEMO_RESULTS + 1][SECONDS_PER_STATE];
+static int duration = 0; // Seconds, 0 when no soak is running
+static int single_state = 0; // Looped demo, 0 for the whole sequence
+static bool finished = false;
+static uint64_t start_usec = 0;
+static char export_path[4200];
+
+void soak_start(int minutes, int state)
+{
+    sample_count = 0;
+    memset(baseline, 0, sizeof(baseline));
+    duration = minutes * 60;
+    single_state = state;
+    finished = false;
+    export_path[0] = '\0';
+    start_usec = get_time_usec();
+}
+
+bool soak_running(void)
+{
+    return duration > 0;
+}
+
+bool soak_finished(void)
+{
+    return finished;
+}
+
+int soak_demo(void)
+{
+    return single_state;
+}
+
+// True once the configured time is up; the caller lets the current demo finish first
+bool soak_time_up(void)
+{
+    return duration > 0 && get_time_usec() - start_usec >= (uint64_t)duration * 1000000;
+}
+
+// One sample per second from the overlay update. FPS differs wildly between
+// demos and between the variants inside one, so each sample is also compared
+// with the first pass over the same second of the same demo.
+void soak_sample(int state, float demo_time, float fps, float temp, float mhz)
+{
+    if (!duration || sample_count >= MAX_SAMPLES)
+        return;
+
+    int second = MIN(MAX((int)demo_time, 0), SECONDS_PER_STATE - 1);
+    float *base = &baseline[MIN(MAX(state, 0), STATE_DEMO_RESULTS)][second];
+    if (*base <= 0)
+        *base = fps;
+
+    soak_sample_t *s = &samples[sample_count++];
+    s->fps = fps;
+    s->relative = *base > 0 ? fps / *base : 1.0f;
+    s->temp = temp;
+    s->mhz = mhz;
+    s->state = state;
+}
+
+// Mean of samples [first, last), ignoring unknown temperatures and clocks
+static soak_level_t mean_level(int first, int last)
+{
+    soak_level_t level = {0, 0, -1, -1};
+    double perf = 0, fps = 0, temp = 0, mhz = 0;
+    int n = 0, n_temp = 0, n_mhz = 0;
+
+    for (int i = MAX(first, 0); i < MIN(last, sample_count); i++)
+    {
+        perf += samples[i].relative;
+        fps += samples[i].fps;
+        n++;
+        if (samples[i].temp >= 0)
+        {
+            temp += samples[i].temp;
+            n_temp++;
+        }
+        if (samples[i].mhz >= 0)
+        {
+            mhz += samples[i].mhz;
+            n_mhz++;
+        }
+    }
+    if (n)
+    {
+        level.perf = (float)(perf / n);
+        level.fps = (float)(fps / n);
+    }
+    if (n_temp)
+        level.temp = (float)(temp / n_temp);
+    if (n_mhz)
+        level.mhz = (float)(mhz / n_mhz);
+    return level;
+}
+
+static soak_level_t initial_level(void)
+{
+    return mean_level(0, INITIAL_TIME);
+}
+
+// The last quarter of the run
+static soak_level_t sustained_level(void)
+{
+    return mean_level(sample_count - sample_count / 4, sample_count);
+}
+
+// First second at which the rolling mean clock falls under DROP of the
+// initial peak, or -1
+static int clock_drop_time(void)
+{
+    float peak = 0;
+    for (int i = 0; i < MIN(INITIAL_TIME, sample_count); i++)
+        peak = fmaxf(peak, samples[i].mhz);
+    if (peak <= 0)
+        return -1;
+
+    for (int i = WINDOW; i <= sample_count; i++)
+    {
+        soak_level_t level = mean_level(i - WINDOW, i);
+        if (level.mhz >= 0 && level.mhz < peak * DROP)
+            return i - WINDOW;
+    }
+    return -1;
+}
+
+// Same for the rolling relative performance
+static int perf_drop_time(void)
+{
+    for (int i = WINDOW; i <= sample_count; i++)
+        if (mean_level(i - WINDOW, i).perf < DROP)
+            return i - WINDOW;
+    return -1;
+}
+
+static void export_series(void)
+{
+    if (retro_base_directory[0])
+        snprintf(export_path, sizeof(export_path), "%s/pibench_soak.csv", retro_base_directory);
+    else
+        snprintf(export_path, sizeof(export_path), "pibench_soak.csv");
+
+    FILE *f = fopen(export_path, "w");
+    if (!f)
+    {
+        export_path[0] = '\0';
+        return;
+    }
+    fprintf(f, "second,state,fps,relative_perf,temp_c,mhz\n");
+    for (int i = 0; i < sample_count; i++)
+        fprintf(f, "%d,%d,%.0f,%.3f,%.1f,%.0f\n", i, samples[i].state, samples[i].fps,
+                samples[i].relative, samples[i].temp, samples[i].mhz);
+    fclose(f);
+}
+
+// End the soak and write the time series to pibench_soak.csv
+void soak_stop(void)
+{
+    if (!duration)
+        return;
+    duration = 0;
+    finished = true;
+    export_series();
+}
+
+static void format_clock(char *buf, size_t size, int seconds)
+{
+    if (seconds < 0)
+        snprintf(buf, size, "--:--");
+    else
+        snprintf(buf, size, "%02d:%02d", seconds / 60, seconds % 60);
+}
+
+// e.g. "Soak 30:00: perf 100% -> 87%, FPS 52.0 -> 45.3, 1800 -> 1500 MHz, 55 -> 82 C, clock drop at 04:12"
+bool format_soak_summary(char *buf, size_t size)
+{
+    char length[16], drop[16];
+
+    if (!finished || !sample_count)
+        return false;
+    soak_level_t first = initial_level(), last = sustained_level();
+    format_clock(length, sizeof(length), sample_count);
+    format_clock(drop, sizeof(drop), clock_drop_time());
+    snprintf(buf, size, "Soak %s: perf %.0f%% -> %.0f%%, FPS %.1f -> %.1f, %.0f -> %.0f MHz, %.0f -> %.0f C, clock drop at %s",
+             length, first.perf * 100, last.perf * 100, first.fps, last.fps, first.mhz, last.mhz,
+             first.temp, last.temp, drop);
+    return true;
+}
+
+static float series_value(const soak_sample_t *s, int series, float mhz_max)
+{
+    switch (series)
+    {
+        case 0:
+            return s->relative / PERF_MAX;
+        case 1:
+            return s->temp < 0 ? -1 : (s->temp - TEMP_MIN) / (TEMP_MAX - TEMP_MIN);
+        default:
+            return s->mhz < 0 ? -1 : s->mhz / mhz_max;
+    }
+}
+
+// Performance, temperature and clock over `span` seconds, each averaged
+// per pixel column
+static void draw_graph(int x, int y, int w, int h, int span)
+{
+    static const uint32_t colors[3] = {0xFF00E436, 0xFFFF004D, 0xFF29ADFF};
+    uint32_t *pixels = (uint32_t *)frame_buf;
+    line_t lines[64];
+    float mhz_max = 1;
+
+    for (int row = y; row < y + h; row++)
+        fill_span(pixels + row * VIDEO_WIDTH + x, w, 0xFF000000);
+    line_t frame[3] = {
+        {x, y + h - 1, x + w - 1, y + h - 1, 0xFF5F574F},
+        {x, y + h - 1 - (h - 1) / PERF_MAX, x + w - 1, y + h - 1 - (h - 1) / PERF_MAX, 0xFF303030}, // 100%
+        {x, y, x, y + h - 1, 0xFF5F574F},
+    };
+    draw_lines(frame, 3);
+
+    for (int i = 0; i < sample_count; i++)
+        mhz_max = fmaxf(mhz_max, samples[i].mhz * 1.1f);
+    span = MAX(span, 1);
+
+    for (int series = 0; series < 3; series++)
+    {
+        int n = 0;
+        float px = -1, py = 0;
+        for (int col = 0; col < w; col++)
+        {
+            int first = col * span / w, last = MIN((col + 1) * span / w, sample_count);
+            float sum = 0;
+            int count = 0;
+            for (int i = first; i < MAX(last, first + 1) && i < sample_count; i++)
+            {
+                float v = series_value(&samples[i], series, mhz_max);
+                if (v >= 0)
+                {
+                    sum += fminf(v, 1.0f);
+                    count++;
+                }
+            }
+            if (!count)
+                continue;
+
+            float cx = x + col, cy = y + h - 1 - sum / count * (h - 1);
+            if (px >= 0)
+                lines[n++] = (line_t){px, py, cx, cy, colors[series]};
+            else
+                pixels[(int)cy * VIDEO_WIDTH + (int)cx] = colors[series];
+            px = cx;
+            py = cy;
+            if (n == 64)
+            {
+                draw_lines(lines, n);
+                n = 0;
+            }
+        }
+        draw_lines(lines, n);
+    }
+}
+
+static void draw_legend(int x, int y, const soak_sample_t *s, int elapsed, int total)
+{
+    char buf[96], now[16], end[16], temp[16], mhz[16];
+
+    format_clock(now, sizeof(now), elapsed);
+    format_clock(end, sizeof(end), total);
+    if (s->temp >= 0)
+        snprintf(temp, sizeof(temp), "%.0fC", s->temp);
+    else
+        snprintf(temp, sizeof(temp), "---C");
+    if (s->mhz >= 0)
+        snprintf(mhz, sizeof(mhz), "%.0fMHZ", s->mhz);
+    else
+        snprintf(mhz, sizeof(mhz), "---MHZ");
+
+    snprintf(buf, sizeof(buf), "PERF %3.0f%%", s->relative * 100);
+    draw_text_bg(x, y, buf, 0xFF00E436);
+    snprintf(buf, sizeof(buf), "TEMP %s", temp);
+    draw_text_bg(x + 96, y, buf, 0xFFFF004D);
+    snprintf(buf, sizeof(buf), "CLOCK %s", mhz);
+    draw_text_bg(x + 192, y, buf, 0xFF29ADFF);
+    snprintf(buf, sizeof(buf), "SOAK %s / %s", now, end);
+    draw_text_bg(x + 328, y, buf, 0xFFFFFFFF);
+}
+
+// Live strip along the bottom of the screen while a soak runs
+void draw_soak_graph(void)
+{
+    if (!duration || !sample_count)
+        return;
+    int elapsed = (int)((get_time_usec() - start_usec) / 1000000);
+    draw_legend(32, 392, &samples[sample_count - 1], elapsed, duration);
+    draw_graph(32, 404, VIDEO_WIDTH - 64, 56, duration);
+}
+
+static void format_level(char *buf, size_t size, const char *name, float initial, float sustained, const char *unit)
+{
+    char a[16], b[16];
+    if (initial >= 0)
+        snprintf(a, sizeof(a), "%.0f%s", initial, unit);
+    else
+        snprintf(a, sizeof(a), "---");
+    if (sustained >= 0)
+        snprintf(b, sizeof(b), "%.0f%s", sustained, unit);
+    else
+        snprintf(b, sizeof(b), "---");
+    snprintf(buf, size, "%-12s %10s %10s", name, a, b);
+}
+
+// Initial (first minute) against sustained (last quarter) levels, when
+// throttling set in and the whole series. Draws nothing until a soak has
+// finished.
+void draw_soak_summary(int x, int y)
+{
+    char buf[96], length[16], clock_drop[16], perf_drop[16];
+
+    if (!finished || !sample_count)
+        return;
+
+    soak_level_t first = initial_level(), last = sustained_level();
+    format_clock(length, sizeof(length), sample_count);
+    snprintf(buf, sizeof(buf), "SOAK TEST: %s, %s", length, single_state ? "ONE DEMO LOOPED" : "WHOLE SEQUENCE LOOPED");
+    draw_text_bg(x, y, buf, 0xFFFFFFFF);
+
+    draw_text_bg(x, y + 16, "                INITIAL  SUSTAINED", 0xFFC2C3C7);
+    format_level(buf, sizeof(buf), "PERFORMANCE", first.perf * 100, last.perf * 100, "%");
+    draw_text_bg(x, y + 24, buf, 0xFF00E436);
+    format_level(buf, sizeof(buf), "TEMPERATURE", first.temp, last.temp, "C");
+    draw_text_bg(x, y + 32, buf, 0xFFFF004D);
+    format_level(buf, sizeof(buf), "CLOCK", first.mhz, last.mhz, "MHZ");
+    draw_text_bg(x, y + 40, buf, 0xFF29ADFF);
+    if (single_state)
+    {
+        format_level(buf, sizeof(buf), "FPS", first.fps, last.fps, "");
+        draw_text_bg(x, y + 48, buf, 0xFFFFFFFF);
+    }
+
+    int clock_time = clock_drop_time(), perf_time = perf_drop_time();
+    if (clock_time < 0 && perf_time < 0)
+    {
+        snprintf(buf, sizeof(buf), "NO THROTTLING DETECTED");
+    }
+    else
+    {
+        format_clock(clock_drop, sizeof(clock_drop), clock_time);
+        format_clock(perf_drop, sizeof(perf_drop), perf_time);
+        snprintf(buf, sizeof(buf), "THROTTLING: CLOCK DROP AT %s, PERF DROP AT %s", clock_drop, perf_drop);
+    }
+    draw_text_bg(x, y + 64, buf, 0xFFFFEC27);
+
+    draw_legend(x + 16, y + 80, &samples[sample_count - 1], sample_count, sample_count);
+    draw_graph(x + 16, y + 92, VIDEO_WIDTH - 2 * x - 32, 88, sample_count);
+
+    if (export_path[0])
+    {
+        size_t len = strlen(export_path);
+        snprintf(buf, sizeof(buf), "SAVED %s%.40s", len > 40 ? "..." : "", export_path + (len > 40 ? len - 40 : 0));
+        draw_text_bg(x, y + 188, buf, 0xFFC2C3C7);
+    }
+}
@@ -0,0 +1,194 @@
+#define _GNU_SOURCE
+#include "pibench.h"
+#include <pthread.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+#include <stdatomic.h>
+
+#define MAX_WORKERS 63
+
+// Persistent worker pool: the calling thread takes jobs alongside the workers
+static pthread_t workers[MAX_WORKERS];
+static int worker_total = 0;
+static int thread_limit = 0; // 0 = use every thread
+static int affinity_cap = 0; // Threads allowed by the affinity mode, 0 = all
+static affinity_t applied_affinity = AFFINITY_OFF;
+#ifdef __linux__
+static cpu_set_t original_set; // The frontend's mask (taskset, cpuset), restored by "off"
+#endif
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t start_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t done_cond = PTHREAD_COND_INITIALIZER;
+static unsigned generation = 0;
+static int busy = 0;
+static bool quit = false;
+
+static struct {
+    job_fn_t fn;
+    void *arg;
+    int jobs;
+    int helpers;
+    atomic_int next;
+} batch;
+
+static void run_jobs(void)
+{
+    int i;
+    while ((i = atomic_fetch_add(&batch.next, 1)) < batch.jobs)
+        batch.fn(i, batch.arg);
+}
+
+static void *worker_main(void *param)
+{
+    int id = (int)(intptr_t)param;
+    unsigned seen = 0;
+
+    pthread_mutex_lock(&lock);
+    for (;;)
+    {
+        while (generation == seen && !quit)
+            pthread_cond_wait(&start_cond, &lock);
+        if (quit)
+            break;
+        seen = generation;
+        if (id >= batch.helpers)
+            continue;
+
+        pthread_mutex_unlock(&lock);
+        run_jobs();
+        pthread_mutex_lock(&lock);
+
+        if (--busy == 0)
+            pthread_cond_signal(&done_cond);
+    }
+    pthread_mutex_unlock(&lock);
+    return NULL;
+}
+
+void threads_init(void)
+{
+    int cores = 1;
+#ifdef __linux__
+    cores = get_cpu_core_count();
+#endif
+    int wanted = MIN(MAX(cores - 1, 0), MAX_WORKERS);
+
+#ifdef __linux__
+    if (pthread_getaffinity_np(pthread_self(), sizeof(original_set), &original_set) != 0)
+    {
+        CPU_ZERO(&original_set);
+        for (int c = 0; c < cpu_cluster_count(); c++)
+            for (int i = 0; i < get_cpu_cluster(c)->count; i++)
+                CPU_SET(get_cpu_cluster(c)->cpus[i], &original_set);
+    }
+#endif
+
+    // Workers wait for generation 1; a count left over from before a
+    // threads_deinit() would wake them on a batch that is already done
+    pthread_mutex_lock(&lock);
+    quit = false;
+    generation = 0;
+    busy = 0;
+    pthread_mutex_unlock(&lock);
+
+    for (worker_total = 0; worker_total < wanted; worker_total++)
+    {
+        if (pthread_create(&workers[worker_total], NULL, worker_main,
+                           (void *)(intptr_t)worker_total) != 0)
+            break;
+    }
+}
+
+void threads_deinit(void)
+{
+    // Hand the frontend's thread back with its original mask
+    set_thread_affinity(AFFINITY_OFF);
+
+    pthread_mutex_lock(&lock);
+    quit = true;
+    pthread_cond_broadcast(&start_cond);
+    pthread_mutex_unlock(&lock);
+
+    for (int i = 0; i < worker_total; i++)
+        pthread_join(workers[i], NULL);
+    worker_total = 0;
+}
+
+// Threads available to run_parallel(), including the caller
+int thread_count(void)
+{
+    int count = worker_total + 1;
+    if (affinity_cap > 0)
+        count = MIN(count, affinity_cap);
+    if (thread_limit > 0)
+        count = MIN(count, thread_limit);
+    return count;
+}
+
+// Cap thread_count() for the scaling sweep; 0 lifts the cap
+void set_thread_limit(int threads)
+{
+    thread_limit = MAX(threads, 0);
+}
+
+#ifdef __linux__
+// Pin to one CPU, or back to the mask threads_init() found when cpu is -1
+static void pin_thread(pthread_t thread, int cpu)
+{
+    cpu_set_t set = original_set;
+    if (cpu >= 0)
+    {
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+    }
+    pthread_setaffinity_np(thread, sizeof(set), &set);
+}
+#endif
+
+// Place the calling thread as thread 0 and the workers after it. Under the
+// big and little modes the pool is also capped to that cluster's cores,
+// so run_parallel() never stacks two threads on one core.
+void set_thread_affinity(affinity_t mode)
+{
+    if (mode == applied_affinity)
+        return;
+    applied_affinity = mode;
+    affinity_cap = affinity_thread_cap(mode);
+#ifdef __linux__
+    pin_thread(pthread_self(), affinity_cpu(mode, 0));
+    for (int i = 0; i < worker_total; i++)
+        pin_thread(workers[i], affinity_cpu(mode, i + 1));
+#endif
+}
+
+// Run fn(0 .. jobs - 1) on up to `threads` threads and wait for all of them
+void run_parallel(int threads, int jobs, job_fn_t fn, void *arg)
+{
+    int helpers = MIN(MIN(threads, thread_count()), jobs) - 1;
+    if (helpers <= 0)
+    {
+        for (int i = 0; i < jobs; i++)
+            fn(i, arg);
+        return;
+    }
+
+    pthread_mutex_lock(&lock);
+    batch.fn = fn;
+    batch.arg = arg;
+    batch.jobs = jobs;
+    batch.helpers = helpers;
+    atomic_store(&batch.next, 0);
+    busy = helpers;
+    generation++;
+    pthread_cond_broadcast(&start_cond);
+    pthread_mutex_unlock(&lock);
+
+    run_jobs();
+
+    pthread_mutex_lock(&lock);
+    while (busy > 0)
+        pthread_cond_wait(&done_cond, &lock);
+    pthread_mutex_unlock(&lock);
+}
@@ -0,0 +1,280 @@
+// Headless libretro frontend for running PiBench without a display, e.g.
+// as a performance gate on build servers. Links the core objects directly,
+// presses START once and runs frames until the results screen is reached.
+//
+// Usage: pibench_headless [-d system_dir] [-f frame.ppm] [-t seconds] [pibench_option=value ...]
+//
+// Exit status: 0 when the run finished, 2 when pibench_baseline=compare
+// found a regression against pibench_baseline.txt, 1 on errors or when
+// the run did not finish within the -t limit.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "../libretro.h"
+
+#define MAX_VARIABLES 32
+
+typedef struct {
+    char key[64];
+    char value[64];
+} variable_t;
+
+static variable_t variables[MAX_VARIABLES];
+static int variable_count = 0;
+static const char *system_dir = ".";
+
+static const void *last_frame = NULL;
+static size_t last_pitch = 0;
+static bool finished = false;
+static int regressions = 0;
+static uint64_t frame_index = 0;
+
+static variable_t *find_variable(const char *key)
+{
+    for (int i = 0; i < variable_count; i++)
+        if (!strcmp(variables[i].key, key))
+            return &variables[i];
+    return NULL;
+}
+
+static void set_variable(const char *key, const char *value)
+{
+    variable_t *var = find_variable(key);
+    if (!var)
+    {
+        if (variable_count == MAX_VARIABLES)
+            return;
+        var = &variables[variable_count++];
+        snprintf(var->key, sizeof(var->key), "%s", key);
+    }
+    snprintf(var->value, sizeof(var->value), "%s", value);
+}
+
+// Defaults come from the core's "Description; first|second|..." strings,
+// like any frontend; command line values are set afterwards and win
+static void set_defaults(const struct retro_variable *vars)
+{
+    for (; vars->key; vars++)
+    {
+        if (find_variable(vars->key))
+            continue;
+        const char *values = strchr(vars->value, ';');
+        if (!values)
+            continue;
+        values++;
+        while (*values == ' ')
+            values++;
+        char first[64];
+        size_t len = strcspn(values, "|");
+        snprintf(first, sizeof(first), "%.*s", (int)(len < sizeof(first) ? len : sizeof(first) - 1), values);
+        set_variable(vars->key, first);
+    }
+}
+
+// Echo the core log and watch it for the end of the run: the composite
+// score is logged when the results screen is reached, after the baseline
+// comparison lines
+static void RETRO_CALLCONV log_printf(enum retro_log_level level, const char *fmt, ...)
+{
+    char line[1024];
+    va_list va;
+    va_start(va, fmt);
+    vsnprintf(line, sizeof(line), fmt, va);
+    va_end(va);
+
+    size_t len = strlen(line);
+    fprintf(level >= RETRO_LOG_WARN ? stderr : stdout, "%s%s", line, (len && line[len - 1] == '\n') ? "" : "\n");
+    fflush(stdout);
+
+    if (!strncmp(line, "Baseline ", 9) && strstr(line, ", REGRESSED)"))
+        regressions++;
+    if (!strncmp(line, "Composite score", 15))
+        finished = true;
+}
+
+static retro_time_t RETRO_CALLCONV get_time_usec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (retro_time_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void RETRO_CALLCONV perf_register(struct retro_perf_counter *counter)
+{
+    counter->registered = true;
+}
+
+static bool RETRO_CALLCONV environment(unsigned cmd, void *data)
+{
+    switch (cmd)
+    {
+        case RETRO_ENVIRONMENT_GET_LOG_INTERFACE:
+            ((struct retro_log_callback *)data)->log = log_printf;
+            return true;
+        case RETRO_ENVIRONMENT_GET_PERF_INTERFACE:
+        {
+            struct retro_perf_callback *perf = (struct retro_perf_callback *)data;
+            memset(perf, 0, sizeof(*perf));
+            perf->get_time_usec = get_time_usec;
+            perf->perf_register = perf_register;
+            return true;
+        }
+        case RETRO_ENVIRONMENT_GET_SYSTEM_DIRECTORY:
+            *(const char **)data = system_dir;
+            return true;
+        case RETRO_ENVIRONMENT_SET_VARIABLES:
+            set_defaults((const struct retro_variable *)data);
+            return true;
+        case RETRO_ENVIRONMENT_GET_VARIABLE:
+        {
+            struct retro_variable *var = (struct retro_variable *)data;
+            variable_t *found = find_variable(var->key);
+            var->value = found ? found->value : NULL;
+            return found != NULL;
+        }
+        case RETRO_ENVIRONMENT_GET_VARIABLE_UPDATE:
+            *(bool *)data = false;
+            return true;
+        case RETRO_ENVIRONMENT_SET_PIXEL_FORMAT:
+            return *(const enum retro_pixel_format *)data == RETRO_PIXEL_FORMAT_XRGB8888;
+        default:
+            return false;
+    }
+}
+
+static void RETRO_CALLCONV video_refresh(const void *data, unsigned width, unsigned height, size_t pitch)
+{
+    (void)width;
+    (void)height;
+    last_frame = data;
+    last_pitch = pitch;
+}
+
+static void RETRO_CALLCONV audio_sample(int16_t left, int16_t right)
+{
+    (void)left;
+    (void)right;
+}
+
+static size_t RETRO_CALLCONV audio_sample_batch(const int16_t *data, size_t frames)
+{
+    (void)data;
+    return frames;
+}
+
+static void RETRO_CALLCONV input_poll(void)
+{
+}
+
+// START is held for the first frame only, which leaves the menu; a press
+// on the results screen would restart the run
+static int16_t RETRO_CALLCONV input_state(unsigned port, unsigned device, unsigned index, unsigned id)
+{
+    (void)index;
+    return port == 0 && device == RETRO_DEVICE_JOYPAD && id == RETRO_DEVICE_ID_JOYPAD_START && frame_index == 0;
+}
+
+// Binary PPM of the last XRGB8888 frame, e.g. the results screen for CI artifacts
+static bool write_frame(const char *path)
+{
+    struct retro_system_av_info av;
+    FILE *f = fopen(path, "wb");
+    if (!f || !last_frame)
+    {
+        if (f)
+            fclose(f);
+        return false;
+    }
+
+    retro_get_system_av_info(&av);
+    unsigned width = av.geometry.base_width, height = av.geometry.base_height;
+    fprintf(f, "P6\n%u %u\n255\n", width, height);
+    for (unsigned y = 0; y < height; y++)
+    {
+        const uint32_t *row = (const uint32_t *)((const uint8_t *)last_frame + y * last_pitch);
+        for (unsigned x = 0; x < width; x++)
+        {
+            uint8_t rgb[3] = {(uint8_t)(row[x] >> 16), (uint8_t)(row[x] >> 8), (uint8_t)row[x]};
+            fwrite(rgb, 1, 3, f);
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s [-d system_dir] [-f frame.ppm] [-t seconds] [pibench_option=value ...]\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    const char *frame_path = NULL;
+    double max_seconds = 0; // No limit
+
+    for (int i = 1; i < argc; i++)
+    {
+        char *eq = strchr(argv[i], '=');
+        if (!strcmp(argv[i], "-d") && i + 1 < argc)
+            system_dir = argv[++i];
+        else if (!strcmp(argv[i], "-f") && i + 1 < argc)
+            frame_path = argv[++i];
+        else if (!strcmp(argv[i], "-t") && i + 1 < argc && (max_seconds = atof(argv[i + 1])) > 0)
+            i++;
+        else if (eq && eq != argv[i])
+        {
+            *eq = '\0';
+            set_variable(argv[i], eq + 1);
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    retro_set_environment(environment);
+    retro_set_video_refresh(video_refresh);
+    retro_set_audio_sample(audio_sample);
+    retro_set_audio_sample_batch(audio_sample_batch);
+    retro_set_input_poll(input_poll);
+    retro_set_input_state(input_state);
+    retro_init();
+
+    struct retro_game_info game = {"", NULL, 0, NULL};
+    if (!retro_load_game(&game))
+    {
+        fprintf(stderr, "pibench_headless: the core refused to start\n");
+        retro_deinit();
+        return 1;
+    }
+
+    // The limit keeps a build server from hanging on a run that never
+    // reaches the results screen
+    retro_time_t deadline = get_time_usec() + (retro_time_t)(max_seconds * 1000000.0);
+    for (frame_index = 0; !finished; frame_index++)
+    {
+        retro_run();
+        if (max_seconds > 0 && !finished && get_time_usec() > deadline)
+        {
+            fprintf(stderr, "pibench_headless: no result after %g seconds\n", max_seconds);
+            retro_unload_game();
+            retro_deinit();
+            return 1;
+        }
+    }
+
+    // One more frame draws the results screen
+    retro_run();
+    if (frame_path && !write_frame(frame_path))
+        fprintf(stderr, "pibench_headless: could not write %s\n", frame_path);
+
+    retro_unload_game();
+    retro_deinit();
+    return regressions ? 2 : 0;
+}
@@ -0,0 +1,260 @@
+#define _GNU_SOURCE
+#include "pibench.h"
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+// CPU clusters ordered fastest first. CPUs are grouped by relative capacity
+// rather than topology/cluster_id, which splits e.g. the RK3588 A76 cores
+// into two pairs that the scheduler treats the same.
+static cpu_cluster_t clusters[MAX_CPUS];
+static int cluster_total = 0;
+static int cluster_of_cpu[MAX_CPUS];
+static uint64_t residency[MAX_CPUS]; // Frames the render thread spent on each cluster
+
+#ifdef __linux__
+static int read_sysfs_int(const char *path)
+{
+    char buf[32];
+    int fd = open(path, O_RDONLY);
+    if (fd == -1)
+        return -1;
+    ssize_t bytes = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (bytes <= 0)
+        return -1;
+    buf[bytes] = '\0';
+    return (int)strtol(buf, NULL, 10);
+}
+
+// Parse a sysfs CPU list such as "0-3,8,10-11"
+static bool read_cpu_list(const char *path, bool *cpus)
+{
+    char buf[256];
+    int fd = open(path, O_RDONLY);
+    if (fd == -1)
+        return false;
+    ssize_t bytes = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (bytes <= 0)
+        return false;
+    buf[bytes] = '\0';
+
+    for (char *p = buf; *p && *p != '\n';)
+    {
+        char *end;
+        long first = strtol(p, &end, 10), last = first;
+        if (end == p)
+            break;
+        if (*end == '-')
+            last = strtol(end + 1, &end, 10);
+        for (long cpu = first; cpu <= last; cpu++)
+            if (cpu >= 0 && cpu < MAX_CPUS)
+                cpus[cpu] = true;
+        p = (*end == ',') ? end + 1 : end;
+    }
+    return true;
+}
+#endif
+
+static void name_clusters(bool hybrid)
+{
+    static const char *names[3][3] = {
+        {"CORE"},
+        {"BIG", "LITTLE"},
+        {"BIG", "MID", "LITTLE"},
+    };
+
+    for (int c = 0; c < cluster_total; c++)
+    {
+        if (hybrid && cluster_total == 2)
+            snprintf(clusters[c].name, sizeof(clusters[c].name), "%s", c ? "E-CORE" : "P-CORE");
+        else if (cluster_total <= 3)
+            snprintf(clusters[c].name, sizeof(clusters[c].name), "%s", names[cluster_total - 1][c]);
+        else
+            snprintf(clusters[c].name, sizeof(clusters[c].name), "CLUSTER %d", c);
+    }
+}
+
+// Reads each online CPU's cpu_capacity, falling back to its maximum clock
+// when the kernel has no capacity table (x86, older Arm kernels). Intel
+// hybrid parts also list their E-cores under /sys/devices/cpu_atom.
+void topology_init(void)
+{
+    bool efficiency[MAX_CPUS] = {false};
+    bool hybrid = false;
+    char path[96];
+
+    if (cluster_total)
+        return;
+    for (int cpu = 0; cpu < MAX_CPUS; cpu++)
+        cluster_of_cpu[cpu] = -1;
+
+#ifdef __linux__
+    hybrid = read_cpu_list("/sys/devices/cpu_atom/cpus", efficiency);
+
+    for (int cpu = 0; cpu < MAX_CPUS; cpu++)
+    {
+        // Offline CPUs have no topology directory
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/core_id", cpu);
+        if (read_sysfs_int(path) < 0)
+            continue;
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpu_capacity", cpu);
+        int capacity = read_sysfs_int(path);
+        if (capacity <= 0)
+        {
+            snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpufreq/cpuinfo_max_freq", cpu);
+            capacity = MAX(read_sysfs_int(path) / 1000, 0);
+        }
+
+        int c = 0;
+        while (c < cluster_total && (clusters[c].capacity != capacity || clusters[c].efficiency != efficiency[cpu]))
+            c++;
+        if (c == cluster_total)
+        {
+            memset(&clusters[c], 0, sizeof(clusters[c]));
+            clusters[c].capacity = capacity;
+            clusters[c].efficiency = efficiency[cpu];
+            cluster_total++;
+        }
+        clusters[c].cpus[clusters[c].count++] = cpu;
+    }
+#endif
+
+    if (!cluster_total)
+    {
+        memset(&clusters[0], 0, sizeof(clusters[0]));
+        clusters[0].count = MIN(MAX(get_cpu_core_count(), 1), MAX_CPUS);
+        for (int i = 0; i < clusters[0].count; i++)
+            clusters[0].cpus[i] = i;
+        cluster_total = 1;
+    }
+
+    // Fastest first; P-cores ahead of E-cores that report the same clock
+    for (int i = 1; i < cluster_total; i++)
+    {
+        cpu_cluster_t t = clusters[i];
+        int j = i;
+        while (j > 0 && (clusters[j - 1].capacity < t.capacity ||
+                         (clusters[j - 1].capacity == t.capacity && clusters[j - 1].efficiency && !t.efficiency)))
+        {
+            clusters[j] = clusters[j - 1];
+            j--;
+        }
+        clusters[j] = t;
+    }
+
+    for (int c = 0; c < cluster_total; c++)
+        for (int i = 0; i < clusters[c].count; i++)
+            cluster_of_cpu[clusters[c].cpus[i]] = c;
+    name_clusters(hybrid);
+}
+
+int cpu_cluster_count(void)
+{
+    topology_init();
+    return cluster_total;
+}
+
+const cpu_cluster_t *get_cpu_cluster(int index)
+{
+    topology_init();
+    return (index >= 0 && index < cluster_total) ? &clusters[index] : NULL;
+}
+
+// e.g. "4x BIG (1024) + 4x LITTLE (446)"
+void format_topology(char *buf, size_t size)
+{
+    size_t len = 0;
+    buf[0] = '\0';
+
+    topology_init();
+    for (int c = 0; c < cluster_total && len < size; c++)
+    {
+        len += snprintf(buf + len, size - len, "%s%dx %s", c ? " + " : "", clusters[c].count, clusters[c].name);
+        if (clusters[c].capacity > 0 && len < size)
+            len += snprintf(buf + len, size - len, " (%d)", clusters[c].capacity);
+    }
+}
+
+// CPU for thread `index` (0 = the render thread) under an affinity mode,
+// or -1 to leave the thread free to run anywhere
+int affinity_cpu(affinity_t mode, int index)
+{
+    topology_init();
+    const cpu_cluster_t *cluster = NULL;
+
+    switch (mode)
+    {
+        case AFFINITY_SPREAD:
+        {
+            // Fill the fastest cluster first, then the next one down
+            int total = 0;
+            for (int c = 0; c < cluster_total; c++)
+                total += clusters[c].count;
+            index %= total;
+            for (int c = 0; c < cluster_total; c++)
+            {
+                if (index < clusters[c].count)
+                    return clusters[c].cpus[index];
+                index -= clusters[c].count;
+            }
+            return -1;
+        }
+        case AFFINITY_BIG:
+            cluster = &clusters[0];
+            break;
+        case AFFINITY_LITTLE:
+            cluster = &clusters[cluster_total - 1];
+            break;
+        default:
+            return -1;
+    }
+    return cluster->cpus[index % cluster->count];
+}
+
+// Threads worth running under a mode: one per core of the chosen cluster
+int affinity_thread_cap(affinity_t mode)
+{
+    topology_init();
+    if (mode == AFFINITY_BIG)
+        return clusters[0].count;
+    if (mode == AFFINITY_LITTLE)
+        return clusters[cluster_total - 1].count;
+    return 0;
+}
+
+// Count the cluster the render thread is on this frame; migrations between
+// core types show up as a split in format_residency()
+void sample_residency(void)
+{
+#ifdef __linux__
+    int cpu = sched_getcpu();
+    if (cpu >= 0 && cpu < MAX_CPUS && cluster_of_cpu[cpu] >= 0)
+        residency[cluster_of_cpu[cpu]]++;
+#endif
+}
+
+void reset_residency(void)
+{
+    memset(residency, 0, sizeof(residency));
+}
+
+// e.g. "BIG 93% LITTLE 7%", returns false before any sample
+bool format_residency(char *buf, size_t size)
+{
+    uint64_t total = 0;
+    size_t len = 0;
+    buf[0] = '\0';
+
+    for (int c = 0; c < cluster_total; c++)
+        total += residency[c];
+    if (!total)
+        return false;
+    for (int c = 0; c < cluster_total && len < size; c++)
+        len += snprintf(buf + len, size - len, "%s%s %d%%", c ? " " : "", clusters[c].name,
+                        (int)(residency[c] * 100 / total));
+    return true;
+}
@@ -13,26 +13,49 @@ int get_cpu_core_count(void)
     // or _SC_NPROCESSORS_CONF for configured cores
 }
 
+// Zone 0 is the SoC sensor on a Pi, but x86 boards often list an ACPI
+// zone first, so a zone whose type names the CPU package wins
+static int open_cpu_thermal_zone(void)
+{
+    char path[64], type[32];
+    int fallback = -1;
+
+    for (int i = 0; i < 16; i++)
+    {
+        snprintf(path, sizeof(path), "/sys/class/thermal/thermal_zone%d/temp", i);
+        int fd = open(path, O_RDONLY);
+        if (fd == -1)
+            continue;
+
+        snprintf(path, sizeof(path), "/sys/class/thermal/thermal_zone%d/type", i);
+        int type_fd = open(path, O_RDONLY);
+        ssize_t bytes = type_fd == -1 ? -1 : read(type_fd, type, sizeof(type) - 1);
+        if (type_fd != -1)
+            close(type_fd);
+        type[MAX(bytes, 0)] = '\0';
+
+        if (strstr(type, "cpu") || strstr(type, "x86_pkg_temp") || strstr(type, "soc"))
+        {
+            if (fallback != -1)
+                close(fallback);
+            return fd;
+        }
+        if (fallback == -1)
+            fallback = fd;
+        else
+            close(fd);
+    }
+    return fallback;
+}
+
 float get_cpu_temperature(void)
 {
     static int last_thermal_fd = -1;
-    static char thermal_path[256] = {0};
     char buf[16];
 
-    // Find thermal zone (try first 6 zones)
     if (last_thermal_fd == -1)
     {
-        for (int i = 0; i < 6; i++)
-        {
-            snprintf(thermal_path, sizeof(thermal_path),
-                     "/sys/class/thermal/thermal_zone%d/temp", i);
-            int fd = open(thermal_path, O_RDONLY);
-            if (fd != -1)
-            {
-                last_thermal_fd = fd;
-                break;
-            }
-        }
+        last_thermal_fd = open_cpu_thermal_zone();
         if (last_thermal_fd == -1)
             return -1;
     }
@@ -47,6 +70,43 @@ float get_cpu_temperature(void)
     return temp / 1000.0f; // Convert millidegrees to Celsius
 }
 
+// Current clock of cpu0 in MHz, or -1 if unknown
+float get_cpu_frequency(void)
+{
+    static int freq_fd = -2;
+    char buf[2048];
+    ssize_t bytes;
+
+    if (freq_fd == -2)
+        freq_fd = open("/sys/devices/system/cpu/cpu0/cpufreq/scaling_cur_freq", O_RDONLY);
+
+    if (freq_fd != -1)
+    {
+        lseek(freq_fd, 0, SEEK_SET);
+        bytes = read(freq_fd, buf, sizeof(buf) - 1);
+        if (bytes <= 0)
+            return -1;
+        buf[bytes] = '\0';
+        return strtol(buf, NULL, 10) / 1000.0f; // Convert kHz to MHz
+    }
+
+    // No cpufreq (common in x86 VMs): fall back to the first "cpu MHz" line
+    int fd = open("/proc/cpuinfo", O_RDONLY);
+    if (fd == -1)
+        return -1;
+    bytes = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (bytes <= 0)
+        return -1;
+    buf[bytes] = '\0';
+
+    char *line = strstr(buf, "cpu MHz");
+    float mhz;
+    if (!line || sscanf(line, "cpu MHz : %f", &mhz) != 1)
+        return -1;
+    return mhz;
+}
+
 float get_cpu_usage(void)
 {
     static int fd = -1;
@@ -184,4 +244,182 @@ void draw_text_bg(int x, int y, const char *text, uint32_t color)
         }
         x += 8; // Move to next character
     }
-}
\ No newline at end of file
+}
+
+uint64_t get_time_usec(void)
+{
+    return perf.get_time_usec ? (uint64_t)perf.get_time_usec() : 0;
+}
+
+static bool last_variant_only = false;
+
+// Index of the variant to run when a demo splits its time evenly between `count` variants
+int demo_variant(float time, int count)
+{
+    if (last_variant_only)
+        return count - 1;
+    return MIN(MAX((int)(time * count / DEMO_TIME), 0), count - 1);
+}
+
+// Demos put their multithreaded variant last, so the scaling sweep can
+// pin them to it
+void force_last_variant(bool enable)
+{
+    last_variant_only = enable;
+}
+
+// Per-demo throughput counters, shown under the overlay and reset per demo
+typedef struct {
+    char label[40];
+    double work;
+    uint64_t usec;
+    double sampled_work;          // Totals at the last sample_demo_stats()
+    uint64_t sampled_usec;
+    double rate_sum, rate_sum_sq; // Per-second rates, for the noise estimate
+    int rate_count;
+} demo_stat_t;
+
+static demo_stat_t demo_stats[MAX_DEMO_STATS];
+
+void add_demo_stat(int slot, const char *label, double work, uint64_t usec)
+{
+    if (slot < 0 || slot >= MAX_DEMO_STATS)
+        return;
+    demo_stat_t *s = &demo_stats[slot];
+    snprintf(s->label, sizeof(s->label), "%s", label);
+    s->work += work;
+    s->usec += usec;
+}
+
+void reset_demo_stats(void)
+{
+    memset(demo_stats, 0, sizeof(demo_stats));
+}
+
+// Average rate of a slot in work units per second, or -1 if unused
+double get_demo_stat(int slot)
+{
+    if (slot < 0 || slot >= MAX_DEMO_STATS || !demo_stats[slot].label[0])
+        return -1;
+    if (!demo_stats[slot].usec)
+        return 0;
+    return demo_stats[slot].work * 1000000.0 / demo_stats[slot].usec;
+}
+
+// Fold the rate since the previous call into the slot's spread; called
+// once a second with the overlay update
+void sample_demo_stats(void)
+{
+    for (int i = 0; i < MAX_DEMO_STATS; i++)
+    {
+        demo_stat_t *s = &demo_stats[i];
+        uint64_t usec = s->usec - s->sampled_usec;
+        if (!s->label[0] || !usec)
+            continue;
+        double rate = (s->work - s->sampled_work) * 1000000.0 / usec;
+        s->rate_sum += rate;
+        s->rate_sum_sq += rate * rate;
+        s->rate_count++;
+        s->sampled_work = s->work;
+        s->sampled_usec = s->usec;
+    }
+}
+
+// Coefficient of variation of a slot's per-second rates, or -1 with fewer
+// than two samples; *count gets the number of samples
+double get_demo_stat_cv(int slot, int *count)
+{
+    *count = 0;
+    if (slot < 0 || slot >= MAX_DEMO_STATS || !demo_stats[slot].label[0])
+        return -1;
+    const demo_stat_t *s = &demo_stats[slot];
+    *count = s->rate_count;
+    if (s->rate_count < 2 || s->rate_sum <= 0)
+        return -1;
+    double mean = s->rate_sum / s->rate_count;
+    double var = fmax(s->rate_sum_sq / s->rate_count - mean * mean, 0.0);
+    return sqrt(var) / mean;
+}
+
+const char *get_demo_stat_label(int slot)
+{
+    if (slot < 0 || slot >= MAX_DEMO_STATS || !demo_stats[slot].label[0])
+        return NULL;
+    return demo_stats[slot].label;
+}
+
+// Short lowercase name of a demo state, as used by core options and result
+// files, or NULL for the menu and results screens
+const char *state_name(int state)
+{
+    static const char *names[] = {
+        "helix", "laser", "radial_lines", "radial_lines_aa", "radial_lines_mt", "noise", "perlin",
+        "fill", "sgemm", "fft", "mesh", "vertex", "texture", "tilemap", "sprites", "composite",
+        "lz", "hash", "latency", "scaling",
+    };
+    if (state < STATE_DEMO_HELIX || state > STATE_DEMO_SCALING)
+        return NULL;
+    return names[state - STATE_DEMO_HELIX];
+}
+
+// Value with two decimals and a K/M/G/T suffix, e.g. "12.34M"
+void format_si(char *buf, size_t size, double value)
+{
+    static const char *suffix[] = {"", "K", "M", "G", "T"};
+    int i = 0;
+
+    while (value >= 1000.0 && i < 4)
+    {
+        value /= 1000.0;
+        i++;
+    }
+    snprintf(buf, size, "%.2f%s", value, suffix[i]);
+}
+
+// Integer hash with good avalanche, for repeatable pseudo-random scenes
+uint32_t hash32(uint32_t h)
+{
+    h ^= h >> 16;
+    h *= 0x7FEB352Du;
+    h ^= h >> 15;
+    h *= 0x846CA68Bu;
+    h ^= h >> 16;
+    return h;
+}
+
+static void format_demo_stat(char *buf, size_t size, int slot)
+{
+    char rate[16];
+    format_si(rate, sizeof(rate), get_demo_stat(slot));
+    snprintf(buf, size, "%.40s: %s", demo_stats[slot].label, rate);
+}
+
+void draw_demo_stats(int x, int y)
+{
+    char buf[64];
+    for (int i = 0; i < MAX_DEMO_STATS; i++)
+    {
+        if (!demo_stats[i].label[0])
+            continue;
+        format_demo_stat(buf, sizeof(buf), i);
+        draw_text_bg(x, y, buf, 0xFFFFFFFF);
+        y += 8;
+    }
+}
+
+// Join all active stats into one log line, returns false if there are none
+bool format_demo_stats(char *buf, size_t size)
+{
+    char item[64];
+    size_t len = 0;
+    buf[0] = '\0';
+
+    for (int i = 0; i < MAX_DEMO_STATS && len < size; i++)
+    {
+        if (!demo_stats[i].label[0])
+            continue;
+        format_demo_stat(item, sizeof(item), i);
+        len += snprintf(buf + len, size - len, "%s%s", len ? " | " : "", item);
+    }
+    return len > 0;
+}